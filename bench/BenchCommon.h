@@ -0,0 +1,33 @@
+#ifndef SIGTA_BENCH_COMMON_H
+#define SIGTA_BENCH_COMMON_H
+
+#include <chrono>
+#include <cstdio>
+
+namespace sigta {
+
+/// Prevent the compiler from optimizing away the computation of value
+template <typename T>
+void doNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// Run fn iterations times, print and return the average time per iteration
+/// in ns
+template <typename FnTy>
+double bench(const char* name, unsigned iterations, FnTy fn) {
+  fn();
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iterations; i++)
+    fn();
+  auto end = std::chrono::steady_clock::now();
+  double ns =
+      std::chrono::duration<double, std::nano>(end - start).count() /
+      iterations;
+  std::printf("%-40s %12.1f ns\n", name, ns);
+  return ns;
+}
+
+} // namespace sigta
+
+#endif
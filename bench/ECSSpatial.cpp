@@ -0,0 +1,74 @@
+#include "sigta/common/ECSSpatial.h"
+#include "sigta/common/ECS.h"
+#include "BenchCommon.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+struct Root;
+using ecs = ecs_impl<Root>;
+struct Root : ecs::EntityBase {};
+
+struct Position {
+  float x, y;
+};
+struct Health {
+  int hp;
+};
+
+using Grid = SpatialGrid<ecs, Position>;
+
+struct Unit final
+    : Root,
+      ecs::EntitySpec<Unit, Root, Position, Health, Grid::Node> {
+  SIGTA_ECS_USING_ENTITY_SPEC;
+};
+
+constexpr unsigned entityCount = 1 << 16;
+constexpr float worldSize = 4096;
+constexpr float radius = 32;
+
+} // namespace
+
+int main() {
+  ecs::init();
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> coord(0, worldSize);
+  std::vector<std::unique_ptr<Unit>> units;
+  Grid grid(radius);
+  for (unsigned i = 0; i < entityCount; i++) {
+    units.push_back(std::make_unique<Unit>());
+    *units.back()->ecs_get<Position>() = {coord(rng), coord(rng)};
+    grid.insert(units.back().get());
+  }
+
+  float x = worldSize / 2, y = worldSize / 2;
+  bench("scan all entities", 100, [&] {
+    int sum = 0;
+    for (auto& unit : units) {
+      Root* ent = unit.get();
+      Position& pos = *ent->ecs_get<Position>();
+      float dx = pos.x - x, dy = pos.y - y;
+      if (dx * dx + dy * dy <= radius * radius)
+        sum += ent->ecs_get<Health>()->hp;
+    }
+    doNotOptimize(sum);
+  });
+  bench("SpatialGrid::withinRadius", 100, [&] {
+    int sum = 0;
+    grid.view<Health>().withinRadius(
+        x, y, radius, [&](Root&, Health& health) { sum += health.hp; });
+    doNotOptimize(sum);
+  });
+  bench("SpatialGrid::update", 100, [&] {
+    for (auto& unit : units) {
+      unit->ecs_get<Position>()->x += 0.5f;
+      grid.update(unit.get());
+    }
+  });
+}
@@ -0,0 +1,50 @@
+#include "sigta/common/ManagedObjs.h"
+#include "BenchCommon.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+constexpr unsigned holdersPerThread = 1 << 18;
+
+struct State {
+  unsigned value = 0;
+};
+
+ManagedGlobal<State> shared;
+ManagedGlobal<State> biased;
+
+/// Create and destroy holders from threadCount threads, while one more holder
+/// keeps the global alive like in a long running program
+template <typename HolderTy>
+void run(unsigned threadCount) {
+  HolderTy keepAlive;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < threadCount; i++)
+    threads.emplace_back([] {
+      for (unsigned j = 0; j < holdersPerThread; j++) {
+        HolderTy holder;
+        doNotOptimize(holder.get().value);
+      }
+    });
+  for (auto &t : threads)
+    t.join();
+}
+
+} // namespace
+
+int main() {
+  std::printf("time for %u holders per thread\n", holdersPerThread);
+  for (unsigned threads = 1; threads <= 64; threads *= 2) {
+    std::string name = "GlobalRefCount x" + std::to_string(threads);
+    bench(name.c_str(), 5, [&] { run<GlobalRefCount<&shared>>(threads); });
+    name = "BiasedGlobalRefCount x" + std::to_string(threads);
+    bench(name.c_str(), 5,
+          [&] { run<BiasedGlobalRefCount<&biased>>(threads); });
+  }
+  BiasedGlobalRefCount<&biased>::flush();
+}
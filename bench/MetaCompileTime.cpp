@@ -0,0 +1,60 @@
+// Entity with SIGTA_BENCH_COMPONENTS components, every one of them queried.
+// Only meant to be compiled, the sigta_bench_meta_compile target times the
+// compilation of this file for several numbers of components.
+
+#include "sigta/common/ECS.h"
+#include "sigta/common/Meta.h"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#ifndef SIGTA_BENCH_COMPONENTS
+#define SIGTA_BENCH_COMPONENTS 10
+#endif
+
+using namespace sigta;
+
+namespace {
+
+template <std::size_t I>
+struct Component {
+  alignas(1 << (I % 4)) char data[I % 3 + 1];
+};
+
+struct Root;
+using ecs = ecs_impl<Root>;
+struct Root : ecs::EntityBase {};
+
+struct Entity;
+
+template <typename SeqTy>
+struct MakeSpec;
+
+template <std::size_t... Is>
+struct MakeSpec<std::index_sequence<Is...>> {
+  using type = ecs::EntitySpec<Entity, Root, Component<Is>...>;
+};
+
+using Indexes = std::make_index_sequence<SIGTA_BENCH_COMPONENTS>;
+
+struct Entity final : Root, MakeSpec<Indexes>::type {
+  SIGTA_ECS_USING_ENTITY_SPEC;
+};
+
+template <std::size_t... Is>
+bool queryAll(Entity& entity, Root& root, std::index_sequence<Is...>) {
+  static_assert(meta::for_all<std::is_trivially_copyable, Component<Is>...>::value);
+  static_assert((Entity::ecs_has<Component<Is>>() && ...));
+  return ((entity.ecs_get<Component<Is>>() ==
+           root.ecs_get<Component<Is>>()) &&
+          ...);
+}
+
+} // namespace
+
+int main() {
+  ecs::init();
+  auto entity = std::make_unique<Entity>();
+  return !queryAll(*entity, *entity, Indexes());
+}
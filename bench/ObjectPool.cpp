@@ -0,0 +1,45 @@
+#include "sigta/common/ObjectPool.h"
+#include "BenchCommon.h"
+
+#include <array>
+#include <cstdint>
+
+using namespace sigta;
+
+namespace {
+
+constexpr unsigned churn = 1 << 16;
+
+struct Message {
+  uint64_t id;
+  uint64_t payload[7];
+  Message(uint64_t i) : id(i) {}
+};
+
+/// Keep a window of live messages, replacing the oldest one each step
+template <typename CreateFnTy, typename DestroyFnTy>
+void run(CreateFnTy create, DestroyFnTy destroy) {
+  std::array<Message*, 64> window{};
+  for (unsigned i = 0; i < churn; i++) {
+    Message*& slot = window[i % window.size()];
+    if (slot)
+      destroy(slot);
+    slot = create(i);
+  }
+  for (Message* msg : window)
+    destroy(msg);
+}
+
+} // namespace
+
+int main() {
+  bench("new/delete", 100, [] {
+    run([](uint64_t i) { return new Message(i); },
+        [](Message* msg) { delete msg; });
+  });
+  ObjectPool<Message> pool;
+  bench("ObjectPool", 100, [&] {
+    run([&](uint64_t i) { return pool.create(i); },
+        [&](Message* msg) { pool.destroy(msg); });
+  });
+}
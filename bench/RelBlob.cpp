@@ -0,0 +1,55 @@
+#include "sigta/common/RelArena.h"
+#include "sigta/common/RelBlob.h"
+#include "BenchCommon.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace sigta;
+
+namespace {
+
+struct Node {
+  RelPtr<Node, int32_t> next;
+  RelString<> label;
+  int64_t payload[4];
+};
+
+struct Root {
+  RelVector<Node> nodes;
+  RelPtr<Node, int32_t> list;
+};
+
+constexpr std::size_t nodeCount = 1 << 18;
+
+} // namespace
+
+template <>
+struct sigta::RelSchema<Node> : RelFields<&Node::next, &Node::label> {};
+template <>
+struct sigta::RelSchema<Root> : RelFields<&Root::nodes, &Root::list> {};
+
+int main() {
+  RelArena<> arena(std::size_t(1) << 30);
+  Root* root = arena.create<Root>();
+  arena.setVector(root->nodes, nodeCount);
+  std::mt19937 rng(0);
+  for (std::size_t i = 0; i < nodeCount; i++) {
+    Node& node = root->nodes.emplace_back();
+    arena.setString(node.label, "node " + std::to_string(i));
+  }
+  // Every node is reached both from the vector and from a shuffled list
+  for (std::size_t i = 0; i < nodeCount; i++)
+    root->nodes[i].next = &root->nodes[rng() % nodeCount];
+  root->list = &root->nodes[0];
+
+  bool ok = true;
+  double ns = bench("RelValidator::run", 20, [&] {
+    ok &= RelValidator(arena.data(), arena.size()).run<Root>();
+  });
+  std::printf("%-40s %12.2f GB/s (%zu bytes)\n", "throughput",
+              arena.size() / ns, arena.size());
+  return !ok;
+}
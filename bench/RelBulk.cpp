@@ -0,0 +1,65 @@
+#include "sigta/common/RelArena.h"
+#include "sigta/common/RelBulk.h"
+#include "BenchCommon.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+constexpr std::size_t valueCount = 1 << 22;
+constexpr std::size_t ptrCount = 1 << 20;
+
+} // namespace
+
+int main() {
+  RelArena<> arena;
+  int64_t* values = arena.createArray<int64_t>(valueCount);
+  auto* ptrs = arena.createArray<RelPtr<int64_t, int32_t>>(ptrCount);
+  std::mt19937 rng(0);
+  for (std::size_t i = 0; i < valueCount; i++)
+    values[i] = i;
+  for (std::size_t i = 0; i < ptrCount; i++)
+    if (rng() % 16)
+      ptrs[i] = &values[rng() % valueCount];
+
+  std::vector<int64_t*> addrs(ptrCount);
+  bench("resolve: get", 20, [&] {
+    for (std::size_t i = 0; i < ptrCount; i++)
+      addrs[i] = ptrs[i].get();
+    doNotOptimize(addrs.data());
+  });
+  bench("resolve: resolveRelPtrs", 20, [&] {
+    resolveRelPtrs(ptrs, ptrCount, addrs.data());
+    doNotOptimize(addrs.data());
+  });
+
+  bench("sum: get", 20, [&] {
+    int64_t sum = 0;
+    for (std::size_t i = 0; i < ptrCount; i++)
+      if (int64_t* p = ptrs[i].get())
+        sum += *p;
+    doNotOptimize(sum);
+  });
+  bench("sum: prefetchRelPtrs", 20, [&] {
+    int64_t sum = 0;
+    for (int64_t* p : prefetchRelPtrs<16>(ptrs, ptrCount))
+      if (p)
+        sum += *p;
+    doNotOptimize(sum);
+  });
+
+  std::vector<int64_t> gathered(ptrCount);
+  bench("gather: get", 20, [&] {
+    for (std::size_t i = 0; i < ptrCount; i++)
+      gathered[i] = ptrs[i] ? *ptrs[i] : 0;
+    doNotOptimize(gathered.data());
+  });
+  bench("gather: gatherRelPtrs", 20, [&] {
+    gatherRelPtrs(ptrs, ptrCount, gathered.data());
+    doNotOptimize(gathered.data());
+  });
+}
@@ -0,0 +1,54 @@
+#include "sigta/common/ManagedObjs.h"
+#include "sigta/common/ShardedGlobal.h"
+#include "BenchCommon.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+constexpr unsigned incrementsPerThread = 1 << 20;
+
+ManagedGlobal<std::atomic<uint64_t>> shared;
+ManagedGlobal<ShardedGlobal<std::atomic<uint64_t>>> sharded;
+
+/// Count events from threadCount threads, each holding the global for its
+/// whole run like a long running worker
+template <typename HolderTy>
+void run(unsigned threadCount) {
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < threadCount; i++)
+    threads.emplace_back([] {
+      HolderTy holder;
+      for (unsigned j = 0; j < incrementsPerThread; j++)
+        holder.get().fetch_add(1, std::memory_order_relaxed);
+    });
+  for (auto &t : threads)
+    t.join();
+}
+
+} // namespace
+
+int main() {
+  GlobalRefCount<&shared> keepShared;
+  ShardedGlobalRefCount<&sharded> keepSharded;
+  std::printf("time for %u increments per thread, %zu shards\n",
+              incrementsPerThread, keepSharded.getAll().size());
+  for (unsigned threads = 1; threads <= 64; threads *= 2) {
+    std::string name = "shared counter x" + std::to_string(threads);
+    bench(name.c_str(), 5, [&] { run<GlobalRefCount<&shared>>(threads); });
+    name = "sharded counter x" + std::to_string(threads);
+    bench(name.c_str(), 5,
+          [&] { run<ShardedGlobalRefCount<&sharded>>(threads); });
+  }
+  uint64_t total = keepSharded.getAll().reduce(
+      uint64_t(0), [](uint64_t sum, const std::atomic<uint64_t> &c) {
+        return sum + c.load(std::memory_order_relaxed);
+      });
+  doNotOptimize(total);
+}
@@ -0,0 +1,93 @@
+#include "sigta/common/Casting.h"
+#include "BenchCommon.h"
+
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+constexpr unsigned depth = 16;
+constexpr unsigned objCount = 1 << 16;
+
+struct Node;
+
+using NodeID = rtti::HierarchyID<Node>;
+
+struct Node {
+  NodeID ID;
+  Node(NodeID id) : ID(id) {}
+  virtual ~Node() = default;
+  NodeID getHierarchyID() const { return ID; }
+};
+
+/// A chain Level<depth - 1> -> ... -> Level<0> -> Node
+template <unsigned N>
+struct Level : Level<N - 1>, NodeID::Inherits<Level<N>, Level<N - 1>> {
+  Level(NodeID id = NodeID::get<Level>()) : Level<N - 1>(id) {}
+};
+
+template <>
+struct Level<0> : Node, NodeID::Inherits<Level<0>, Node> {
+  Level(NodeID id = NodeID::get<Level>()) : Node(id) {}
+};
+
+template <unsigned... Ns>
+std::unique_ptr<Node> makeLevel(unsigned n,
+                                std::integer_sequence<unsigned, Ns...>) {
+  std::unique_ptr<Node> res;
+  ((n == Ns ? (void)(res = std::make_unique<Level<Ns>>()) : (void)0), ...);
+  return res;
+}
+
+} // namespace
+
+int main() {
+  NodeID::init();
+
+  std::mt19937 rng(0);
+  std::vector<std::unique_ptr<Node>> objs;
+  for (unsigned i = 0; i < objCount; i++)
+    objs.push_back(makeLevel(rng() % depth,
+                             std::make_integer_sequence<unsigned, depth>{}));
+
+  bench("isa: dynamic_cast", 100, [&] {
+    unsigned count = 0;
+    for (auto& obj : objs)
+      count += dynamic_cast<Level<depth / 2>*>(obj.get()) != nullptr;
+    doNotOptimize(count);
+  });
+  bench("isa: HierarchyID", 100, [&] {
+    unsigned count = 0;
+    for (auto& obj : objs)
+      count += rtti::dyn_cast<Level<depth / 2>>(obj.get()) != nullptr;
+    doNotOptimize(count);
+  });
+
+  bench("switch: dynamic_cast chain", 100, [&] {
+    unsigned sum = 0;
+    for (auto& obj : objs) {
+      if (dynamic_cast<Level<12>*>(obj.get()))
+        sum += 4;
+      else if (dynamic_cast<Level<8>*>(obj.get()))
+        sum += 3;
+      else if (dynamic_cast<Level<4>*>(obj.get()))
+        sum += 2;
+      else if (dynamic_cast<Level<1>*>(obj.get()))
+        sum += 1;
+    }
+    doNotOptimize(sum);
+  });
+  bench("switch: type_switch", 100, [&] {
+    unsigned sum = 0;
+    for (auto& obj : objs)
+      sum += rtti::type_switch<Level<1>, Level<4>, Level<8>, Level<12>>(
+          *obj, [](Level<1>&) { return 1u; }, [](Level<4>&) { return 2u; },
+          [](Level<8>&) { return 3u; }, [](Level<12>&) { return 4u; },
+          [](Node&) { return 0u; });
+    doNotOptimize(sum);
+  });
+}
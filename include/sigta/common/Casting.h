@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+// Provide isa, cast, dyn_cast and type_switch on top of HierarchyID.
+//
+// An object takes part by exposing getHierarchyID() returning the ID of its
+// dynamic class. The checks are then range checks on that ID instead of
+// dynamic_cast walking the vtable.
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_CASTING_H
+#define SIGTA_COMMON_CASTING_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sigta/common/RTTI.h"
+
+namespace sigta {
+namespace rtti {
+
+namespace cast_detail {
+
+template <typename FromTy>
+using HIDOf =
+    std::decay_t<decltype(std::declval<const FromTy&>().getHierarchyID())>;
+
+template <typename FromTy, typename ToTy>
+using CopyConst =
+    std::conditional_t<std::is_const_v<FromTy>, const ToTy, ToTy>;
+
+/// Table mapping every ID of the hierarchy to the index in CaseTys of the
+/// most derived case containing it, or sizeof...(CaseTys) if none does.
+/// Built on first use so it must only be used after HierarchyID::init().
+template <typename HIDTy, typename... CaseTys>
+const std::vector<uint8_t>& getSwitchTable() {
+  static const std::vector<uint8_t> table = [] {
+    constexpr std::size_t caseCount = sizeof...(CaseTys);
+    typename HIDTy::Range ranges[] = {HIDTy::template getRange<CaseTys>()...};
+    std::size_t order[caseCount];
+    for (std::size_t idx = 0; idx < caseCount; idx++)
+      order[idx] = idx;
+
+    // IDs are assigned in DFS pre-order, so filling ranges by increasing min
+    // lets subclasses overwrite their parents. On duplicated cases the first
+    // one is filled last so it wins.
+    std::sort(order, order + caseCount, [&](std::size_t l, std::size_t r) {
+      if (ranges[l].min != ranges[r].min)
+        return ranges[l].min < ranges[r].min;
+      return l > r;
+    });
+
+    auto base = HIDTy::minID().getInt();
+    std::vector<uint8_t> res(HIDTy::maxID().getInt() - base, caseCount);
+    for (std::size_t idx : order)
+      std::fill(res.begin() + (ranges[idx].min - base),
+                res.begin() + (ranges[idx].max - base), (uint8_t)idx);
+    return res;
+  }();
+  return table;
+}
+
+template <typename FromTy, typename TupleTy, typename... CaseTys>
+struct Switcher {
+  static constexpr std::size_t caseCount = sizeof...(CaseTys);
+  static constexpr bool hasDefault = std::tuple_size_v<TupleTy> > caseCount;
+
+  template <std::size_t Idx>
+  using CaseTy =
+      CopyConst<FromTy, std::tuple_element_t<Idx, std::tuple<CaseTys...>>>;
+
+  using RetTy = std::invoke_result_t<std::tuple_element_t<0, TupleTy>,
+                                     CaseTy<0>&>;
+
+  template <std::size_t Idx>
+  static RetTy call(FromTy& obj, TupleTy& fns) {
+    if constexpr (Idx < caseCount)
+      return std::get<Idx>(fns)(static_cast<CaseTy<Idx>&>(obj));
+    else if constexpr (hasDefault)
+      return std::get<Idx>(fns)(obj);
+    else {
+      assert(false && "no case matched and there is no default");
+      __builtin_unreachable();
+    }
+  }
+
+  template <std::size_t... Idxs>
+  static RetTy dispatch(std::size_t idx, FromTy& obj, TupleTy& fns,
+                        std::index_sequence<Idxs...>) {
+    using ThunkTy = RetTy (*)(FromTy&, TupleTy&);
+    static constexpr ThunkTy thunks[] = {&call<Idxs>...};
+    return thunks[idx](obj, fns);
+  }
+};
+
+} // namespace cast_detail
+
+/// Return true if obj is of class ToTy or one of its subclasses
+template <typename ToTy, typename FromTy>
+bool isa(const FromTy* obj) {
+  assert(obj && "isa on a null pointer");
+  return cast_detail::HIDOf<FromTy>::template isclassof<ToTy>(
+      obj->getHierarchyID());
+}
+
+template <typename ToTy, typename FromTy,
+          typename = std::enable_if_t<!std::is_pointer_v<FromTy>>>
+bool isa(const FromTy& obj) {
+  return isa<ToTy>(&obj);
+}
+
+/// Checked static_cast, obj must be of class ToTy or one of its subclasses
+template <typename ToTy, typename FromTy>
+cast_detail::CopyConst<FromTy, ToTy>* cast(FromTy* obj) {
+  assert(isa<ToTy>(obj) && "invalid cast");
+  return static_cast<cast_detail::CopyConst<FromTy, ToTy>*>(obj);
+}
+
+template <typename ToTy, typename FromTy,
+          typename = std::enable_if_t<!std::is_pointer_v<FromTy>>>
+cast_detail::CopyConst<FromTy, ToTy>& cast(FromTy& obj) {
+  return *cast<ToTy>(&obj);
+}
+
+/// Equivalent of dynamic_cast, return nullptr if obj is null or not of class
+/// ToTy
+template <typename ToTy, typename FromTy>
+cast_detail::CopyConst<FromTy, ToTy>* dyn_cast(FromTy* obj) {
+  return (obj && isa<ToTy>(obj)) ? cast<ToTy>(obj) : nullptr;
+}
+
+/// Call the callable matching the most derived class in CaseTys that obj is an
+/// instance of, with obj casted to it. fns should contain one callable per
+/// case, optionally followed by a default callable taking obj uncasted.
+/// All callables must return the same type.
+/// The resolution is a single lookup in a table built on first use.
+template <typename... CaseTys, typename FromTy, typename... FnTys>
+decltype(auto) type_switch(FromTy& obj, FnTys&&... fns) {
+  static_assert(sizeof...(CaseTys) > 0, "expected at least one case");
+  static_assert(sizeof...(CaseTys) < std::numeric_limits<uint8_t>::max(),
+                "too many cases");
+  static_assert(sizeof...(FnTys) == sizeof...(CaseTys) ||
+                    sizeof...(FnTys) == sizeof...(CaseTys) + 1,
+                "expected one callable per case and an optional default");
+  using HIDTy = cast_detail::HIDOf<FromTy>;
+  using TupleTy = std::tuple<FnTys&&...>;
+  const std::vector<uint8_t>& table =
+      cast_detail::getSwitchTable<HIDTy, CaseTys...>();
+  std::size_t idx =
+      table[obj.getHierarchyID().getInt() - HIDTy::minID().getInt()];
+  TupleTy tuple(std::forward<FnTys>(fns)...);
+  return cast_detail::Switcher<FromTy, TupleTy, CaseTys...>::dispatch(
+      idx, obj, tuple, std::make_index_sequence<sizeof...(CaseTys) + 1>{});
+}
+
+} // namespace rtti
+} // namespace sigta
+
+#endif
@@ -0,0 +1,334 @@
+//===----------------------------------------------------------------------===//
+// Provide bulk versions of HierarchyID::isclassof over arrays of IDs or
+// objects.
+//
+// A class and all of its subclasses occupy a contiguous range of IDs, so
+// testing membership is a single range check. On arrays of 16 or 32 bits IDs
+// this check is done with SSE2 or AVX2, with a scalar fallback otherwise.
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_CLASS_FILTER_H
+#define SIGTA_COMMON_CLASS_FILTER_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#define SIGTA_CLASS_FILTER_SIMD 1
+#else
+#define SIGTA_CLASS_FILTER_SIMD 0
+#endif
+
+#include "sigta/common/RTTI.h"
+
+namespace sigta {
+namespace rtti {
+
+namespace filter_detail {
+
+/// Range check done with a single unsigned comparison
+template <typename IDTy>
+bool inRange(IDTy id, IDTy min, IDTy max) {
+  using UTy = std::make_unsigned_t<IDTy>;
+  return static_cast<UTy>(id - min) < static_cast<UTy>(max - min);
+}
+
+#if SIGTA_CLASS_FILTER_SIMD
+struct Vec {
+#if defined(__AVX2__)
+  using Ty = __m256i;
+  static constexpr std::size_t bytes = 32;
+  static Ty load(const void* p) { return _mm256_loadu_si256((const Ty*)p); }
+  static void store(void* p, Ty v) { _mm256_storeu_si256((Ty*)p, v); }
+  static uint32_t mask(Ty v) { return (uint32_t)_mm256_movemask_epi8(v); }
+  static Ty bitXor(Ty a, Ty b) { return _mm256_xor_si256(a, b); }
+  static Ty bitAnd(Ty a, Ty b) { return _mm256_and_si256(a, b); }
+  static Ty bitOr(Ty a, Ty b) { return _mm256_or_si256(a, b); }
+  static Ty bitAndNot(Ty a, Ty b) { return _mm256_andnot_si256(a, b); }
+  template <std::size_t Size>
+  static Ty set1(uint32_t v) {
+    if constexpr (Size == 2)
+      return _mm256_set1_epi16((short)v);
+    else
+      return _mm256_set1_epi32((int)v);
+  }
+  template <std::size_t Size>
+  static Ty sub(Ty a, Ty b) {
+    if constexpr (Size == 2)
+      return _mm256_sub_epi16(a, b);
+    else
+      return _mm256_sub_epi32(a, b);
+  }
+  template <std::size_t Size>
+  static Ty cmpgt(Ty a, Ty b) {
+    if constexpr (Size == 2)
+      return _mm256_cmpgt_epi16(a, b);
+    else
+      return _mm256_cmpgt_epi32(a, b);
+  }
+#else
+  using Ty = __m128i;
+  static constexpr std::size_t bytes = 16;
+  static Ty load(const void* p) { return _mm_loadu_si128((const Ty*)p); }
+  static void store(void* p, Ty v) { _mm_storeu_si128((Ty*)p, v); }
+  static uint32_t mask(Ty v) { return (uint32_t)_mm_movemask_epi8(v); }
+  static Ty bitXor(Ty a, Ty b) { return _mm_xor_si128(a, b); }
+  static Ty bitAnd(Ty a, Ty b) { return _mm_and_si128(a, b); }
+  static Ty bitOr(Ty a, Ty b) { return _mm_or_si128(a, b); }
+  static Ty bitAndNot(Ty a, Ty b) { return _mm_andnot_si128(a, b); }
+  template <std::size_t Size>
+  static Ty set1(uint32_t v) {
+    if constexpr (Size == 2)
+      return _mm_set1_epi16((short)v);
+    else
+      return _mm_set1_epi32((int)v);
+  }
+  template <std::size_t Size>
+  static Ty sub(Ty a, Ty b) {
+    if constexpr (Size == 2)
+      return _mm_sub_epi16(a, b);
+    else
+      return _mm_sub_epi32(a, b);
+  }
+  template <std::size_t Size>
+  static Ty cmpgt(Ty a, Ty b) {
+    if constexpr (Size == 2)
+      return _mm_cmpgt_epi16(a, b);
+    else
+      return _mm_cmpgt_epi32(a, b);
+  }
+#endif
+  static constexpr uint32_t fullMask = (uint32_t)((1ull << bytes) - 1);
+};
+
+/// Vectorized version of inRange. There is no unsigned comparison for packed
+/// integers so both sides are biased by the sign bit and compared signed.
+template <typename IDTy>
+class RangeTester {
+  static constexpr std::size_t size = sizeof(IDTy);
+  Vec::Ty bias;
+  Vec::Ty min;
+  Vec::Ty len;
+
+public:
+  static constexpr std::size_t lanes = Vec::bytes / size;
+  /// Bits set in the result of test for each lane
+  static constexpr uint32_t laneMask = (1u << size) - 1;
+
+  RangeTester(IDTy lo, IDTy hi)
+      : bias(Vec::set1<size>(1u << (size * 8 - 1))),
+        min(Vec::set1<size>((uint32_t)lo)),
+        len(Vec::bitXor(Vec::set1<size>((uint32_t)(IDTy)(hi - lo)), bias)) {}
+
+  Vec::Ty testVec(Vec::Ty v) const {
+    return Vec::cmpgt<size>(len, Vec::bitXor(Vec::sub<size>(v, min), bias));
+  }
+  uint32_t test(const IDTy* p) const {
+    return Vec::mask(testVec(Vec::load(p)));
+  }
+};
+#endif
+
+template <typename IDTy>
+constexpr bool hasVec =
+    SIGTA_CLASS_FILTER_SIMD && (sizeof(IDTy) == 2 || sizeof(IDTy) == 4);
+
+template <typename IDTy>
+std::size_t count(const IDTy* ids, std::size_t size, IDTy min, IDTy max) {
+  std::size_t idx = 0;
+  std::size_t result = 0;
+#if SIGTA_CLASS_FILTER_SIMD
+  if constexpr (hasVec<IDTy>) {
+    RangeTester<IDTy> tester(min, max);
+    std::size_t bits = 0;
+    for (; idx + tester.lanes <= size; idx += tester.lanes)
+      bits += __builtin_popcount(tester.test(ids + idx));
+    result = bits / sizeof(IDTy);
+  }
+#endif
+  for (; idx < size; idx++)
+    result += inRange(ids[idx], min, max);
+  return result;
+}
+
+/// Copy every id in range, or out of range if Keep is false, to out
+template <bool Keep, typename IDTy>
+std::size_t filter(const IDTy* ids, std::size_t size, IDTy* out, IDTy min,
+                   IDTy max) {
+  std::size_t idx = 0;
+  std::size_t result = 0;
+#if SIGTA_CLASS_FILTER_SIMD
+  if constexpr (hasVec<IDTy>) {
+    RangeTester<IDTy> tester(min, max);
+    for (; idx + tester.lanes <= size; idx += tester.lanes) {
+      uint32_t mask = tester.test(ids + idx);
+      if (!Keep)
+        mask = ~mask & Vec::fullMask;
+      while (mask) {
+        unsigned bit = __builtin_ctz(mask);
+        out[result++] = ids[idx + bit / sizeof(IDTy)];
+        mask &= ~(tester.laneMask << bit);
+      }
+    }
+  }
+#endif
+  for (; idx < size; idx++)
+    if (inRange(ids[idx], min, max) == Keep)
+      out[result++] = ids[idx];
+  return result;
+}
+
+/// Write in out the index of the range containing each id or rangeCount.
+template <typename IDTy, typename RangeTy>
+void classify(const IDTy* ids, std::size_t size, const RangeTy* ranges,
+              std::size_t rangeCount, uint8_t* out) {
+  assert(rangeCount < std::numeric_limits<uint8_t>::max() &&
+         "too many ranges");
+#ifndef NDEBUG
+  for (std::size_t r1 = 0; r1 < rangeCount; r1++)
+    for (std::size_t r2 = 0; r2 < r1; r2++)
+      assert((ranges[r1].max <= ranges[r2].min ||
+              ranges[r2].max <= ranges[r1].min) &&
+             "ranges should be disjoint");
+#endif
+  std::size_t idx = 0;
+#if SIGTA_CLASS_FILTER_SIMD
+  if constexpr (hasVec<IDTy>) {
+    constexpr std::size_t lanes = RangeTester<IDTy>::lanes;
+    Vec::Ty none = Vec::set1<sizeof(IDTy)>((uint32_t)rangeCount);
+    for (; idx + lanes <= size; idx += lanes) {
+      Vec::Ty v = Vec::load(ids + idx);
+      Vec::Ty res = none;
+      for (std::size_t r = 0; r < rangeCount; r++) {
+        Vec::Ty m = RangeTester<IDTy>(ranges[r].min, ranges[r].max).testVec(v);
+        res = Vec::bitOr(Vec::bitAndNot(m, res),
+                         Vec::bitAnd(m, Vec::set1<sizeof(IDTy)>((uint32_t)r)));
+      }
+      IDTy buf[lanes];
+      Vec::store(buf, res);
+      for (std::size_t lane = 0; lane < lanes; lane++)
+        out[idx + lane] = (uint8_t)buf[lane];
+    }
+  }
+#endif
+  for (; idx < size; idx++) {
+    uint8_t res = (uint8_t)rangeCount;
+    for (std::size_t r = 0; r < rangeCount; r++)
+      if (inRange<IDTy>(ids[idx], ranges[r].min, ranges[r].max))
+        res = (uint8_t)r;
+    out[idx] = res;
+  }
+}
+
+/// HierarchyID is a standard-layout wrapper around its integer, so arrays of
+/// it can be processed as arrays of integers.
+template <typename HIDTy>
+using IntOf = decltype(std::declval<HIDTy>().getInt());
+
+template <typename HIDTy>
+const IntOf<HIDTy>* asInts(const HIDTy* ids) {
+  static_assert(std::is_standard_layout_v<HIDTy> &&
+                    sizeof(HIDTy) == sizeof(IntOf<HIDTy>),
+                "expected a HierarchyID");
+  return reinterpret_cast<const IntOf<HIDTy>*>(ids);
+}
+
+template <typename HIDTy>
+IntOf<HIDTy>* asInts(HIDTy* ids) {
+  return const_cast<IntOf<HIDTy>*>(asInts((const HIDTy*)ids));
+}
+
+} // namespace filter_detail
+
+/// Return how many of ids are Ty or one of its subclasses
+template <typename Ty, typename HIDTy>
+std::size_t countClassOf(const HIDTy* ids, std::size_t size) {
+  auto range = HIDTy::template getRange<Ty>();
+  return filter_detail::count(filter_detail::asInts(ids), size, range.min,
+                              range.max);
+}
+
+/// Copy to out every id that is Ty or one of its subclasses, preserving order.
+/// Return the number of ids written, out should have space for size ids.
+template <typename Ty, typename HIDTy>
+std::size_t filterClassOf(const HIDTy* ids, std::size_t size, HIDTy* out) {
+  auto range = HIDTy::template getRange<Ty>();
+  return filter_detail::filter<true>(filter_detail::asInts(ids), size,
+                                     filter_detail::asInts(out), range.min,
+                                     range.max);
+}
+
+/// Copy to out every id that is Ty or one of its subclasses followed by every
+/// other ids, preserving order in both groups. Return the number of ids in the
+/// first group.
+template <typename Ty, typename HIDTy>
+std::size_t partitionClassOf(const HIDTy* ids, std::size_t size, HIDTy* out) {
+  auto range = HIDTy::template getRange<Ty>();
+  std::size_t count = filter_detail::filter<true>(
+      filter_detail::asInts(ids), size, filter_detail::asInts(out), range.min,
+      range.max);
+  filter_detail::filter<false>(filter_detail::asInts(ids), size,
+                               filter_detail::asInts(out + count), range.min,
+                               range.max);
+  return count;
+}
+
+/// Write in out[i] the index of the range that contains ids[i] or rangeCount
+/// if there is none. The ranges must be disjoint.
+template <typename HIDTy>
+void classifyClassOf(const typename HIDTy::Range* ranges,
+                     std::size_t rangeCount, const HIDTy* ids,
+                     std::size_t size, uint8_t* out) {
+  filter_detail::classify(filter_detail::asInts(ids), size, ranges, rangeCount,
+                          out);
+}
+
+/// Write in out[i] the index in Tys of the class of ids[i] or sizeof...(Tys)
+/// if none of Tys matches. The classes must not be subclasses of each other.
+template <typename... Tys, typename HIDTy>
+void classifyClassOf(const HIDTy* ids, std::size_t size, uint8_t* out) {
+  typename HIDTy::Range ranges[] = {HIDTy::template getRange<Tys>()...};
+  classifyClassOf(ranges, sizeof...(Tys), ids, size, out);
+}
+
+/// Overloads for sequences of objects, proj should return the HierarchyID of
+/// an object.
+
+template <typename Ty, typename ItTy, typename ProjTy>
+std::size_t countClassOf(ItTy first, ItTy last, ProjTy proj) {
+  using HIDTy = std::decay_t<decltype(proj(*first))>;
+  auto range = HIDTy::template getRange<Ty>();
+  return std::count_if(first, last,
+                       [&](const auto& obj) { return range.contains(proj(obj)); });
+}
+
+template <typename Ty, typename ItTy, typename OutItTy, typename ProjTy>
+OutItTy filterClassOf(ItTy first, ItTy last, OutItTy out, ProjTy proj) {
+  using HIDTy = std::decay_t<decltype(proj(*first))>;
+  auto range = HIDTy::template getRange<Ty>();
+  return std::copy_if(first, last, out, [&](const auto& obj) {
+    return range.contains(proj(obj));
+  });
+}
+
+/// Reorder in place so that objects of class Ty come first. Return the end of
+/// that group.
+template <typename Ty, typename ItTy, typename ProjTy>
+ItTy partitionClassOf(ItTy first, ItTy last, ProjTy proj) {
+  using HIDTy = std::decay_t<decltype(proj(*first))>;
+  auto range = HIDTy::template getRange<Ty>();
+  return std::partition(first, last, [&](const auto& obj) {
+    return range.contains(proj(obj));
+  });
+}
+
+} // namespace rtti
+} // namespace sigta
+
+#endif
@@ -4,7 +4,8 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "sigta/common/Meta.h"
@@ -17,6 +18,34 @@ namespace ecs_detail {
 
 template <typename, typename, typename, typename...> class EntitySpec;
 
+template <std::size_t I, typename Cmp,
+          bool IsEmpty = std::is_empty_v<Cmp> && !std::is_final_v<Cmp>>
+struct ComponentSlot {
+  Cmp value{};
+  Cmp &get() { return value; }
+};
+
+/// Empty components are bases, so like in std::tuple they take no space
+template <std::size_t I, typename Cmp>
+struct ComponentSlot<I, Cmp, true> : Cmp {
+  ComponentSlot() : Cmp() {}
+  Cmp &get() { return *this; }
+};
+
+/// Flat replacement for std::tuple<CmpTys...>, whose recursive implementation
+/// dominates compile time for entities with many components.
+template <typename SeqTy, typename... CmpTys> struct ComponentStorage;
+
+template <std::size_t... Is, typename... CmpTys>
+struct ComponentStorage<std::index_sequence<Is...>, CmpTys...>
+    : ComponentSlot<Is, CmpTys>... {
+  template <typename Cmp, std::size_t I, bool IsEmpty>
+  static Cmp &get(ComponentSlot<I, Cmp, IsEmpty> &slot) {
+    return slot.get();
+  }
+  template <typename Cmp> Cmp &get() { return get<Cmp>(*this); }
+};
+
 template <typename ECS> class EntityBase {
 
   template <typename, typename, typename, typename...> friend class EntitySpec;
@@ -45,9 +74,13 @@ public:
 
 template <typename ECS, typename ParentTy, typename ParentBaseTy,
           typename... CmpTys>
-class EntitySpec : std::tuple<CmpTys...>,
-                   ECS::entityRTTI::template Inherits<ParentTy, ParentBaseTy> {
-  using Tuple = std::tuple<CmpTys...>;
+class EntitySpec
+    : ComponentStorage<std::index_sequence_for<CmpTys...>, CmpTys...>,
+      ECS::entityRTTI::template Inherits<ParentTy, ParentBaseTy> {
+  static_assert(meta::is_unique_v<CmpTys...>,
+                "a component can only appear once in an EntitySpec");
+  using Storage =
+      ComponentStorage<std::index_sequence_for<CmpTys...>, CmpTys...>;
 
   ParentTy *getParent() const {
     return static_cast<ParentTy *>(const_cast<EntitySpec *>(this));
@@ -57,8 +90,8 @@ class EntitySpec : std::tuple<CmpTys...>,
     return static_cast<typename ECS::rootTy *>(getParent());
   }
 
-  Tuple *getTuple() const {
-    return static_cast<Tuple *>(const_cast<EntitySpec *>(this));
+  Storage *getStorage() const {
+    return static_cast<Storage *>(const_cast<EntitySpec *>(this));
   }
 
   static auto getEntityID() {
@@ -66,13 +99,13 @@ class EntitySpec : std::tuple<CmpTys...>,
   }
 
   struct initTable {
-    initTable(char *addr, Tuple *t) {
+    initTable(char *addr, Storage *s) {
       (([&] {
          using Cmp = CmpTys;
          if constexpr (ecs_has<Cmp>()) {
            ECS::getOffset(getEntityID(),
                           ECS::componentRTTI::template get<Cmp>()) =
-               ((char *)&std::get<Cmp>(*t)) - addr;
+               ((char *)&s->template get<Cmp>()) - addr;
          }
        }()),
        ...);
@@ -80,7 +113,7 @@ class EntitySpec : std::tuple<CmpTys...>,
   };
 
   void fillTableOnFirstUse() {
-    static initTable init(getRoot()->getAddr(), getTuple());
+    static initTable init(getRoot()->getAddr(), getStorage());
   }
 
 public:
@@ -95,11 +128,11 @@ public:
     getRoot()->ID = getEntityID();
   }
   template <typename Ty> static constexpr bool ecs_has() {
-    return meta::Layout<CmpTys...>::template has<Ty>();
+    return meta::contains_v<Ty, CmpTys...>;
   }
   template <typename Ty> Ty *ecs_get() {
     static_assert(ecs_has<Ty>(), "component doesn't exist");
-    return &std::get<Ty>(*getTuple());
+    return &getStorage()->template get<Ty>();
   }
   template <typename Ty> Ty *ecs_get_or_null() {
     if constexpr (ecs_has<Ty>())
@@ -141,7 +174,7 @@ public:
     entityRTTI::init();
     Table.assign(entityRTTI::maxID().getInt() * componentRTTI::maxID().getInt(),
                  invalidOffset);
-    lineLength = entityRTTI::maxID().getInt();
+    lineLength = componentRTTI::maxID().getInt();
   }
 
   using EntityBase = ecs_detail::EntityBase<ecs_impl>;
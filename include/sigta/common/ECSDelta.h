@@ -0,0 +1,216 @@
+//===----------------------------------------------------------------------===//
+//
+// This file provides ReplicatedWorld, a list of ECS entities whose components
+// can be sent to replicas as deltas containing only what changed since a
+// given version.
+//
+// Writes go through ReplicatedWorld::write, which stamps the entity and its
+// chunk of chunkSize entities with the current version, per component. The
+// encoder skips every chunk whose version is too old, so an idle world costs
+// one comparison per chunk and component.
+//
+// The replica must hold entities of the same kinds, added in the same order.
+// Deltas are in native byte order and only meant for identical builds.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_ECSDELTA_H
+#define SIGTA_COMMON_ECSDELTA_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "sigta/common/Meta.h"
+
+namespace sigta {
+
+namespace ecsdelta_detail {
+
+struct Header {
+  static constexpr uint32_t magicValue = 0x4c444753; // "SGDL"
+  uint32_t magic;
+  uint32_t recordCount;
+  uint64_t fromVersion;
+  uint64_t toVersion;
+};
+
+/// Followed by size bytes of component
+struct Record {
+  uint32_t entity;
+  uint16_t column;
+  uint16_t size;
+};
+
+} // namespace ecsdelta_detail
+
+template <typename ECS, typename... CmpTys>
+class ReplicatedWorld {
+  static_assert(sizeof...(CmpTys) > 0, "nothing to replicate");
+  static_assert(meta::is_unique_v<CmpTys...>,
+                "a component can only be replicated once");
+  static_assert(meta::for_all<std::is_trivially_copyable, CmpTys...>::value,
+                "replicated components are sent as bytes");
+  static_assert(((sizeof(CmpTys) <= std::numeric_limits<uint16_t>::max()) &&
+                 ...),
+                "component too large for a delta record");
+
+public:
+  using RootTy = typename ECS::rootTy;
+  using VersionTy = uint64_t;
+  static constexpr std::size_t chunkSize = 64;
+
+private:
+  using Header = ecsdelta_detail::Header;
+  using Record = ecsdelta_detail::Record;
+
+  static constexpr std::size_t columnCount = sizeof...(CmpTys);
+  static constexpr std::size_t sizes[] = {sizeof(CmpTys)...};
+
+  template <typename Cmp> static char *getBytes(RootTy *entity) {
+    return reinterpret_cast<char *>(
+        entity->template ecs_get_or_null<Cmp>());
+  }
+  using GetBytesFn = char *(*)(RootTy *);
+  static constexpr GetBytesFn getters[] = {&getBytes<CmpTys>...};
+
+  std::vector<RootTy *> Entities;
+  /// Version of the last write for each entity and column, 0 if never written
+  std::vector<VersionTy> EntityVersions;
+  /// Latest of EntityVersions over each chunk, for each column
+  std::vector<VersionTy> ChunkVersions;
+  VersionTy Version = 1;
+  /// toVersion of the last delta applied to this world
+  VersionTy AppliedVersion = 0;
+
+  void mark(std::size_t idx, std::size_t column) {
+    EntityVersions[idx * columnCount + column] = Version;
+    ChunkVersions[(idx / chunkSize) * columnCount + column] = Version;
+  }
+
+  template <typename T> static T readAt(const char *addr) {
+    T res;
+    std::memcpy(&res, addr, sizeof(T));
+    return res;
+  }
+
+  template <typename T> static void appendTo(std::vector<char> &out, T value) {
+    const char *bytes = reinterpret_cast<const char *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+  }
+
+  /// Return true if every record of the delta can be applied
+  bool validate(const char *data, std::size_t size, const Header &hdr) const {
+    std::size_t pos = sizeof(Header);
+    for (uint32_t idx = 0; idx < hdr.recordCount; idx++) {
+      if (size - pos < sizeof(Record))
+        return false;
+      Record rec = readAt<Record>(data + pos);
+      pos += sizeof(Record);
+      if (rec.entity >= Entities.size() || rec.column >= columnCount ||
+          rec.size != sizes[rec.column] || size - pos < rec.size ||
+          !getters[rec.column](Entities[rec.entity]))
+        return false;
+      pos += rec.size;
+    }
+    return pos == size;
+  }
+
+public:
+  ReplicatedWorld() = default;
+
+  /// Add entity at the end of the world and mark all its components changed.
+  /// Return its index.
+  std::size_t add(RootTy *entity) {
+    assert(Entities.size() < std::numeric_limits<uint32_t>::max());
+    std::size_t idx = Entities.size();
+    Entities.push_back(entity);
+    EntityVersions.resize(Entities.size() * columnCount, 0);
+    ChunkVersions.resize(
+        ((Entities.size() + chunkSize - 1) / chunkSize) * columnCount, 0);
+    for (std::size_t column = 0; column < columnCount; column++)
+      if (getters[column](entity))
+        mark(idx, column);
+    return idx;
+  }
+
+  std::size_t size() const { return Entities.size(); }
+  RootTy *operator[](std::size_t idx) const { return Entities[idx]; }
+  VersionTy getVersion() const { return Version; }
+  VersionTy getAppliedVersion() const { return AppliedVersion; }
+
+  template <typename Cmp> const Cmp *read(std::size_t idx) const {
+    return Entities[idx]->template ecs_get<Cmp>();
+  }
+
+  /// Access Cmp of the entity at idx for writing, it will be part of the next
+  /// delta.
+  template <typename Cmp> Cmp *write(std::size_t idx) {
+    static_assert(meta::contains_v<Cmp, CmpTys...>, "Cmp isn't replicated");
+    Cmp *res = Entities[idx]->template ecs_get<Cmp>();
+    mark(idx, meta::find_v<Cmp, CmpTys...>);
+    return res;
+  }
+
+  /// Append to out the components written after version since and start a
+  /// new version. Return the version to pass as since for the next delta of a
+  /// replica that applied this one.
+  VersionTy encode(VersionTy since, std::vector<char> &out) {
+    std::size_t headerPos = out.size();
+    appendTo(out, Header{Header::magicValue, 0, since, Version});
+    uint32_t count = 0;
+    for (std::size_t chunk = 0; chunk * chunkSize < Entities.size(); chunk++)
+      for (std::size_t column = 0; column < columnCount; column++) {
+        if (ChunkVersions[chunk * columnCount + column] <= since)
+          continue;
+        std::size_t end = std::min(Entities.size(), (chunk + 1) * chunkSize);
+        for (std::size_t idx = chunk * chunkSize; idx < end; idx++) {
+          if (EntityVersions[idx * columnCount + column] <= since)
+            continue;
+          const char *bytes = getters[column](Entities[idx]);
+          appendTo(out, Record{(uint32_t)idx, (uint16_t)column,
+                               (uint16_t)sizes[column]});
+          out.insert(out.end(), bytes, bytes + sizes[column]);
+          count++;
+        }
+      }
+    std::memcpy(out.data() + headerPos + offsetof(Header, recordCount), &count,
+                sizeof(count));
+    return Version++;
+  }
+
+  /// Patch the components of this world with a delta. Nothing is changed and
+  /// false is returned if the delta is malformed, doesn't match this world,
+  /// depends on a version that wasn't applied or is older than the last delta
+  /// applied. Patched components are marked
+  /// changed, so a replica can itself be replicated.
+  bool apply(const void *delta, std::size_t size) {
+    const char *data = static_cast<const char *>(delta);
+    if (size < sizeof(Header))
+      return false;
+    Header hdr = readAt<Header>(data);
+    // Stale, duplicated or reordered deltas would roll the replica back
+    if (hdr.magic != Header::magicValue || hdr.fromVersion > AppliedVersion ||
+        hdr.toVersion <= AppliedVersion || !validate(data, size, hdr))
+      return false;
+    for (std::size_t pos = sizeof(Header); pos < size;) {
+      Record rec = readAt<Record>(data + pos);
+      pos += sizeof(Record);
+      std::memcpy(getters[rec.column](Entities[rec.entity]), data + pos,
+                  rec.size);
+      mark(rec.entity, rec.column);
+      pos += rec.size;
+    }
+    AppliedVersion = hdr.toVersion;
+    return true;
+  }
+};
+
+} // namespace sigta
+
+#endif // SIGTA_COMMON_ECSDELTA_H
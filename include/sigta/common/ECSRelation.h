@@ -0,0 +1,245 @@
+//===----------------------------------------------------------------------===//
+//
+// This file provides relationship components for the ECS: Hierarchy for
+// parent/child trees, and Targets for bounded one-to-many links stored
+// contiguously in the entity.
+//
+// Each Hierarchy node keeps the links to its children in one array allocated
+// in a RelArena, so iterating the children reads contiguous links and only
+// touches the child entities themselves.
+//
+// Links are RelPtr, so traversals don't go through the offset table of the
+// ECS, and links within one block of memory survive relocating the block:
+// Targets of entities in an ObjectPool or RelArena, and Hierarchy when the
+// entities are in the RelArena holding the children.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_ECSRELATION_H
+#define SIGTA_COMMON_ECSRELATION_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "sigta/common/RelArena.h"
+#include "sigta/common/RelContainers.h"
+#include "sigta/common/RelPtr.h"
+
+namespace sigta {
+
+/// Component making its entity a node of a tree. Tag distinguishes independent
+/// trees over the same entities. Destroying a node detaches it and orphans its
+/// children.
+///
+/// The children of a node are an array of links allocated in the RelArena
+/// passed to attach, which must outlive the nodes. The array doubles when it
+/// is full, the previous one is left unused in the arena. Detaching a child
+/// moves the last child to its place.
+template <typename RootTy, typename Tag = void,
+          typename IntTy = std::ptrdiff_t>
+class Hierarchy {
+public:
+  using Link = RelPtr<RootTy, IntTy>;
+  using ChildrenTy = RelSpan<Link, IntTy>;
+
+private:
+  /// Set when the node is first linked
+  RelPtr<RootTy, IntTy> Owner;
+  RelPtr<Hierarchy, IntTy> Parent;
+  RelVector<Link, IntTy> Children;
+  /// Index of this node in the children of Parent
+  uint32_t IndexInParent = 0;
+
+  static Hierarchy &getNode(RootTy *entity) {
+    Hierarchy *node = entity->template ecs_get<Hierarchy>();
+    if (!node->Owner)
+      node->Owner = entity;
+    assert(node->Owner.get() == entity);
+    return *node;
+  }
+
+  bool isAncestorOf(const Hierarchy &other) const {
+    for (Hierarchy *node = other.Parent.get(); node; node = node->Parent.get())
+      if (node == this)
+        return true;
+    return false;
+  }
+
+  /// Make room for one more child, return false if the arena is full
+  bool reserveChild(RelArena<IntTy> &arena) {
+    if (Children.size() < Children.capacity())
+      return true;
+    assert(Children.size() < std::numeric_limits<uint32_t>::max());
+    Link *prev = Children.data();
+    std::size_t count = Children.size();
+    if (!arena.setVector(Children, count ? count * 2 : 4))
+      return false;
+    for (std::size_t idx = 0; idx < count; idx++)
+      Children.emplace_back(prev[idx].get());
+    return true;
+  }
+
+public:
+  Hierarchy() = default;
+  ~Hierarchy() {
+    detach();
+    for (Link &child : Children)
+      getNode(child.get()).Parent = nullptr;
+  }
+
+  /// The Hierarchy component of entity
+  static Hierarchy &of(RootTy *entity) { return getNode(entity); }
+
+  /// Make child the last child of parent, detaching it from its previous
+  /// parent first. Return false and change nothing if the children of parent
+  /// need to grow and arena is full.
+  static bool attach(RelArena<IntTy> &arena, RootTy *parent, RootTy *child) {
+    Hierarchy &p = getNode(parent);
+    Hierarchy &c = getNode(child);
+    assert(&p != &c && !c.isAncestorOf(p) && "would create a cycle");
+    if (!p.reserveChild(arena))
+      return false;
+    c.detach();
+    c.Parent = &p;
+    c.IndexInParent = (uint32_t)p.Children.size();
+    p.Children.emplace_back(child);
+    return true;
+  }
+
+  /// Remove this node from the children of its parent, its own children stay
+  /// attached to it.
+  void detach() {
+    if (!Parent)
+      return;
+    RelVector<Link, IntTy> &siblings = Parent->Children;
+    if (IndexInParent != siblings.size() - 1) {
+      RootTy *moved = siblings[siblings.size() - 1].get();
+      siblings[IndexInParent] = moved;
+      getNode(moved).IndexInParent = IndexInParent;
+    }
+    siblings.pop_back();
+    Parent = nullptr;
+  }
+
+  RootTy *getOwner() const { return Owner.get(); }
+  RootTy *getParent() const { return Parent ? Parent->getOwner() : nullptr; }
+  bool hasChildren() const { return !Children.empty(); }
+  /// The links to the children, contiguous in the arena
+  const ChildrenTy &getChildren() const { return Children; }
+
+  /// Call fn(RootTy&) on each child
+  template <typename FnTy> void forEachChild(FnTy fn) const {
+    for (const Link &child : Children)
+      fn(*child);
+  }
+
+  /// Call fn(RootTy&, Cmp&) on each child that has the component Cmp
+  template <typename Cmp, typename FnTy> void forEachChildWith(FnTy fn) const {
+    for (const Link &child : Children)
+      if (Cmp *cmp = child->template ecs_get_or_null<Cmp>())
+        fn(*child, *cmp);
+  }
+
+  /// Call fn(RootTy& parent, RootTy& child) on every descendant, in pre-order
+  /// so a parent is always visited before its children, which is what
+  /// transform propagation needs. This doesn't recurse and doesn't allocate.
+  /// fn must not change the tree.
+  template <typename FnTy> void forEachDescendant(FnTy fn) const {
+    const Hierarchy *node = this;
+    std::size_t idx = 0;
+    while (true) {
+      if (idx < node->Children.size()) {
+        RootTy *child = node->Children[idx].get();
+        fn(*node->getOwner(), *child);
+        const Hierarchy &childNode = getNode(child);
+        if (childNode.hasChildren()) {
+          node = &childNode;
+          idx = 0;
+        } else {
+          idx++;
+        }
+        continue;
+      }
+      if (node == this)
+        return;
+      idx = node->IndexInParent + 1;
+      node = node->Parent.get();
+    }
+  }
+};
+
+/// Component holding up to Capacity links to other entities, stored
+/// contiguously inside the entity. Tag distinguishes independent relationships.
+/// Targets are not notified of the links to them, they must be removed before
+/// the target is destroyed.
+template <typename RootTy, std::size_t Capacity, typename Tag = void,
+          typename IntTy = std::ptrdiff_t>
+class Targets {
+  RelPtr<RootTy, IntTy> Links[Capacity];
+  std::uint32_t Count = 0;
+
+public:
+  Targets() = default;
+
+  /// The Targets component of entity
+  static Targets &of(RootTy *entity) {
+    return *entity->template ecs_get<Targets>();
+  }
+
+  std::size_t size() const { return Count; }
+  bool empty() const { return Count == 0; }
+  static constexpr std::size_t capacity() { return Capacity; }
+  RootTy *operator[](std::size_t idx) const {
+    assert(idx < Count);
+    return Links[idx].get();
+  }
+
+  bool contains(RootTy *target) const {
+    for (std::size_t idx = 0; idx < Count; idx++)
+      if (Links[idx].get() == target)
+        return true;
+    return false;
+  }
+
+  /// Return false if there is no room left or target is already linked
+  bool add(RootTy *target) {
+    assert(target);
+    if (Count == Capacity || contains(target))
+      return false;
+    Links[Count++] = target;
+    return true;
+  }
+
+  /// Return false if target wasn't linked. Keeps the order of other targets.
+  bool remove(RootTy *target) {
+    for (std::size_t idx = 0; idx < Count; idx++) {
+      if (Links[idx].get() != target)
+        continue;
+      for (; idx + 1 < Count; idx++)
+        Links[idx] = Links[idx + 1].get();
+      Links[--Count] = nullptr;
+      return true;
+    }
+    return false;
+  }
+
+  /// Call fn(RootTy&) on each target
+  template <typename FnTy> void forEach(FnTy fn) const {
+    for (std::size_t idx = 0; idx < Count; idx++)
+      fn(*Links[idx]);
+  }
+
+  /// Call fn(RootTy&, Cmp&) on each target that has the component Cmp
+  template <typename Cmp, typename FnTy> void forEachWith(FnTy fn) const {
+    forEach([&](RootTy &target) {
+      if (Cmp *cmp = target.template ecs_get_or_null<Cmp>())
+        fn(target, *cmp);
+    });
+  }
+};
+
+} // namespace sigta
+
+#endif // SIGTA_COMMON_ECSRELATION_H
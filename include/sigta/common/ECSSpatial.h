@@ -0,0 +1,253 @@
+//===----------------------------------------------------------------------===//
+//
+// This file provides SpatialGrid, a uniform grid indexing ECS entities by a
+// position component, so that neighbour queries only visit the cells
+// overlapping the query instead of every entity.
+//
+// Indexed entities need a SpatialNode component recording where they are in
+// the grid, and must be removed from the grid before being destroyed. The
+// grid is maintained incrementally: update() only moves an entity between
+// cells when it crossed a cell boundary. Each cell stores the positions next
+// to the entities, so candidates are filtered without touching the entities.
+//
+// Queries compose with the components to fetch:
+//   grid.view<Velocity, Health>().within(box, [](Root&, Velocity&, Health&) {
+//     ...
+//   });
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_ECSSPATIAL_H
+#define SIGTA_COMMON_ECSSPATIAL_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace sigta {
+
+/// How SpatialGrid reads a position component, specialize it for position
+/// types without x and y members.
+template <typename PosCmp> struct SpatialPosition {
+  static float getX(const PosCmp &pos) { return pos.x; }
+  static float getY(const PosCmp &pos) { return pos.y; }
+};
+
+/// Axis aligned box, bounds included
+struct SpatialBox {
+  float minX, minY, maxX, maxY;
+  bool contains(float x, float y) const {
+    return x >= minX && x <= maxX && y >= minY && y <= maxY;
+  }
+};
+
+template <typename, typename, typename, typename> class SpatialGrid;
+
+/// Component of the entities indexed by the SpatialGrids with the same Tag.
+/// The grid keeps a pointer to the entity, so an entity must be removed from
+/// its grid before it is destroyed, which is asserted.
+template <typename Tag = void> class SpatialNode {
+  template <typename, typename, typename, typename> friend class SpatialGrid;
+  int32_t CellX = 0;
+  int32_t CellY = 0;
+  uint32_t Slot = 0;
+  bool Indexed = false;
+
+public:
+  SpatialNode() = default;
+  ~SpatialNode() {
+    assert(!Indexed && "entity destroyed while still in a SpatialGrid");
+  }
+
+  bool isIndexed() const { return Indexed; }
+};
+
+template <typename ECS, typename PosCmp, typename Tag = void,
+          typename PosTraits = SpatialPosition<PosCmp>>
+class SpatialGrid {
+public:
+  using RootTy = typename ECS::rootTy;
+  using Node = SpatialNode<Tag>;
+
+private:
+  struct Entry {
+    float x;
+    float y;
+    RootTy *entity;
+  };
+  using Cell = std::vector<Entry>;
+
+  float InvCellSize;
+  std::unordered_map<uint64_t, Cell> Cells;
+  std::size_t Count = 0;
+
+  static uint64_t getKey(int32_t cellX, int32_t cellY) {
+    return ((uint64_t)(uint32_t)cellX << 32) | (uint32_t)cellY;
+  }
+  /// Coordinates beyond the range of int32_t cells, like a query box using
+  /// +/-FLT_MAX for everywhere, are clamped to the border cells
+  int32_t toCell(float value) const {
+    assert(!std::isnan(value));
+    double cell = std::floor((double)value * InvCellSize);
+    return (int32_t)std::clamp(
+        cell, (double)std::numeric_limits<int32_t>::min(),
+        (double)std::numeric_limits<int32_t>::max());
+  }
+  static Node &getNode(RootTy *entity) {
+    return *entity->template ecs_get<Node>();
+  }
+  static const PosCmp &getPos(RootTy *entity) {
+    return *entity->template ecs_get<PosCmp>();
+  }
+
+  void link(RootTy *entity, Node &node, float x, float y) {
+    node.CellX = toCell(x);
+    node.CellY = toCell(y);
+    Cell &cell = Cells[getKey(node.CellX, node.CellY)];
+    node.Slot = (uint32_t)cell.size();
+    node.Indexed = true;
+    cell.push_back({x, y, entity});
+  }
+
+  void unlink(Node &node) {
+    auto it = Cells.find(getKey(node.CellX, node.CellY));
+    assert(it != Cells.end());
+    Cell &cell = it->second;
+    if (node.Slot != cell.size() - 1) {
+      cell[node.Slot] = cell.back();
+      getNode(cell[node.Slot].entity).Slot = node.Slot;
+    }
+    cell.pop_back();
+    if (cell.empty())
+      Cells.erase(it);
+    node.Indexed = false;
+  }
+
+  /// Call fn(Entry&) on every entry inside box
+  template <typename FnTy> void forEachEntry(const SpatialBox &box, FnTy fn) {
+    int32_t minX = toCell(box.minX), maxX = toCell(box.maxX);
+    int32_t minY = toCell(box.minY), maxY = toCell(box.maxY);
+    auto visit = [&](Cell &cell) {
+      for (Entry &entry : cell)
+        if (box.contains(entry.x, entry.y))
+          fn(entry);
+    };
+    if (minX > maxX || minY > maxY)
+      return;
+    uint64_t width = (uint64_t)((int64_t)maxX - minX + 1);
+    uint64_t height = (uint64_t)((int64_t)maxY - minY + 1);
+    // Large boxes are cheaper to answer by walking the occupied cells. This is
+    // width * height > Cells.size() without overflowing.
+    if (width > Cells.size() || height > Cells.size() / width) {
+      for (auto &[key, cell] : Cells) {
+        int32_t cellX = (int32_t)(key >> 32), cellY = (int32_t)key;
+        if (cellX >= minX && cellX <= maxX && cellY >= minY && cellY <= maxY)
+          visit(cell);
+      }
+      return;
+    }
+    // 64 bits so the loops end when the box reaches the last cell
+    for (int64_t cellX = minX; cellX <= maxX; cellX++)
+      for (int64_t cellY = minY; cellY <= maxY; cellY++) {
+        auto it = Cells.find(getKey((int32_t)cellX, (int32_t)cellY));
+        if (it != Cells.end())
+          visit(it->second);
+      }
+  }
+
+public:
+  /// cellSize should be around the typical query radius
+  explicit SpatialGrid(float cellSize) : InvCellSize(1 / cellSize) {
+    assert(cellSize > 0);
+  }
+  /// The entities still indexed must be alive
+  ~SpatialGrid() {
+    for (auto &[key, cell] : Cells)
+      for (Entry &entry : cell)
+        getNode(entry.entity).Indexed = false;
+  }
+  SpatialGrid(const SpatialGrid &) = delete;
+  SpatialGrid &operator=(const SpatialGrid &) = delete;
+
+  std::size_t size() const { return Count; }
+  std::size_t countCells() const { return Cells.size(); }
+
+  void insert(RootTy *entity) {
+    Node &node = getNode(entity);
+    assert(!node.Indexed && "already indexed");
+    const PosCmp &pos = getPos(entity);
+    link(entity, node, PosTraits::getX(pos), PosTraits::getY(pos));
+    Count++;
+  }
+
+  void remove(RootTy *entity) {
+    Node &node = getNode(entity);
+    assert(node.Indexed && "not indexed");
+    unlink(node);
+    Count--;
+  }
+
+  /// Call after the position of entity changed
+  void update(RootTy *entity) {
+    Node &node = getNode(entity);
+    assert(node.Indexed && "not indexed");
+    const PosCmp &pos = getPos(entity);
+    float x = PosTraits::getX(pos), y = PosTraits::getY(pos);
+    if (toCell(x) == node.CellX && toCell(y) == node.CellY) {
+      Entry &entry = Cells.find(getKey(node.CellX, node.CellY))
+                         ->second[node.Slot];
+      entry.x = x;
+      entry.y = y;
+      return;
+    }
+    unlink(node);
+    link(entity, node, x, y);
+  }
+
+  /// Entities of the grid that have all of CmpTys
+  template <typename... CmpTys> class View {
+    SpatialGrid &Grid;
+
+    template <typename FnTy> static void call(RootTy &entity, FnTy &fn) {
+      std::tuple<CmpTys *...> cmps{
+          entity.template ecs_get_or_null<CmpTys>()...};
+      if (((std::get<CmpTys *>(cmps) != nullptr) && ...))
+        fn(entity, *std::get<CmpTys *>(cmps)...);
+    }
+
+  public:
+    explicit View(SpatialGrid &grid) : Grid(grid) {}
+
+    /// Call fn(RootTy&, CmpTys&...) on the entities inside box
+    template <typename FnTy> void within(const SpatialBox &box, FnTy fn) {
+      Grid.forEachEntry(box, [&](Entry &entry) { call(*entry.entity, fn); });
+    }
+
+    /// Call fn(RootTy&, CmpTys&...) on the entities at most radius away from
+    /// (x, y)
+    template <typename FnTy>
+    void withinRadius(float x, float y, float radius, FnTy fn) {
+      SpatialBox box{x - radius, y - radius, x + radius, y + radius};
+      float sqRadius = radius * radius;
+      Grid.forEachEntry(box, [&](Entry &entry) {
+        float dx = entry.x - x, dy = entry.y - y;
+        if (dx * dx + dy * dy <= sqRadius)
+          call(*entry.entity, fn);
+      });
+    }
+  };
+
+  template <typename... CmpTys> View<CmpTys...> view() {
+    return View<CmpTys...>(*this);
+  }
+};
+
+} // namespace sigta
+
+#endif // SIGTA_COMMON_ECSSPATIAL_H
@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <thread>
 #include <cassert>
+#include <string_view>
 
 namespace sigta {
 namespace extra{
@@ -18,6 +19,21 @@ void assertSingleThread() {
   assert(id == std::this_thread::get_id());
 }
 
+/// FNV-1a hash, it is stable across builds and processes
+constexpr uint64_t hashBytes(std::string_view bytes) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (char c : bytes)
+    hash = (hash ^ (uint8_t)c) * 0x100000001b3;
+  return hash;
+}
+
+/// Mix the bits of an integer, it is stable across builds and processes
+constexpr uint64_t hashInt(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+  return value ^ (value >> 31);
+}
+
 template<typename ParentTy>
 struct EquallyComparable {
   const ParentTy* getParent() const { return static_cast<const ParentTy*>(this); }
@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+// Provide GlobalInitializer, to construct ManagedGlobal objects on background
+// threads ahead of their first use.
+//
+// Each global added to the initializer is constructed by a pool of threads
+// once all the globals it depends on are constructed, so independent globals
+// are constructed in parallel. A thread creating a GlobalRefCount on a global
+// that is being constructed waits for it, and one on a global whose
+// construction didn't start yet constructs it itself. GlobalRefCount::is_ready
+// can be used to avoid waiting.
+//
+// The initializer holds a reference on every global it constructed until it
+// is destroyed.
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_GLOBAL_INIT_H
+#define SIGTA_COMMON_GLOBAL_INIT_H
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sigta/common/ManagedObjs.h"
+
+namespace sigta {
+
+class GlobalInitializer {
+  struct Task {
+    const void* global;
+    void (*acquire)(const void*);
+    void (*release)(const void*);
+    std::vector<std::size_t> dependents;
+    /// Number of dependencies not constructed yet
+    std::size_t pending = 0;
+    bool done = false;
+
+    Task(const void* g, void (*acq)(const void*), void (*rel)(const void*))
+        : global(g), acquire(acq), release(rel) {}
+  };
+
+  std::vector<Task> tasks;
+  std::vector<std::thread> workers;
+  std::mutex mtx;
+  std::condition_variable cond;
+  std::vector<std::size_t> readyTasks;
+  std::size_t doneCount = 0;
+
+  template <typename T>
+  static ManagedGlobal<T>* cast(const void* global) {
+    return const_cast<ManagedGlobal<T>*>(
+        static_cast<const ManagedGlobal<T>*>(global));
+  }
+
+  std::size_t find(const void* global) const {
+    for (std::size_t idx = 0; idx < tasks.size(); idx++)
+      if (tasks[idx].global == global)
+        return idx;
+    // Continuing would index out of tasks, so fail in every build mode
+    std::fprintf(stderr, "GlobalInitializer: dependencies should be added "
+                         "before the globals depending on them\n");
+    std::abort();
+  }
+
+  void addDependency(std::size_t task, const void* dependency) {
+    Task& dep = tasks[find(dependency)];
+    dep.dependents.push_back(task);
+    tasks[task].pending++;
+  }
+
+  void work() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+      cond.wait(lock, [&] {
+        return !readyTasks.empty() || doneCount == tasks.size();
+      });
+      if (readyTasks.empty())
+        return;
+      std::size_t idx = readyTasks.back();
+      readyTasks.pop_back();
+      lock.unlock();
+      tasks[idx].acquire(tasks[idx].global);
+      lock.lock();
+      tasks[idx].done = true;
+      doneCount++;
+      for (std::size_t dependent : tasks[idx].dependents)
+        if (--tasks[dependent].pending == 0)
+          readyTasks.push_back(dependent);
+      cond.notify_all();
+    }
+  }
+
+public:
+  GlobalInitializer() = default;
+  GlobalInitializer(const GlobalInitializer&) = delete;
+  GlobalInitializer& operator=(const GlobalInitializer&) = delete;
+  /// Wait for every construction and release the references on the globals
+  ~GlobalInitializer() {
+    for (std::thread& t : workers)
+      t.join();
+    for (Task& task : tasks)
+      if (task.done)
+        task.release(task.global);
+  }
+
+  /// Construct global after every one of deps, which must already be added.
+  /// Must not be called after start.
+  template <typename T, typename... DepTys>
+  void add(ManagedGlobal<T>* global, ManagedGlobal<DepTys>*... deps) {
+    assert(workers.empty() && "initialization already started");
+    tasks.emplace_back(
+        global, [](const void* g) { cast<T>(g)->init_or_inc_ref_count(); },
+        [](const void* g) { cast<T>(g)->dec_ref_count_and_maybe_destroy(); });
+    (addDependency(tasks.size() - 1, deps), ...);
+  }
+
+  /// Start constructing the globals on threadCount threads
+  void start(unsigned threadCount = std::thread::hardware_concurrency()) {
+    assert(workers.empty() && "initialization already started");
+    for (std::size_t idx = 0; idx < tasks.size(); idx++)
+      if (tasks[idx].pending == 0)
+        readyTasks.push_back(idx);
+    // The first tasks added are started first
+    std::reverse(readyTasks.begin(), readyTasks.end());
+    threadCount = std::max(1u, threadCount);
+    for (unsigned idx = 0; idx < threadCount; idx++)
+      workers.emplace_back([this] { work(); });
+  }
+
+  /// Wait until every global is constructed
+  void wait() {
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [&] { return doneCount == tasks.size(); });
+  }
+
+  /// Return true if every global is constructed
+  bool done() {
+    std::lock_guard<std::mutex> g(mtx);
+    return doneCount == tasks.size();
+  }
+};
+
+} // namespace sigta
+
+#endif
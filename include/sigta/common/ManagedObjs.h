@@ -4,8 +4,8 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <mutex>
-#include <shared_mutex>
 #include <utility>
 
 namespace sigta {
@@ -39,6 +39,10 @@ public:
     return get_internal();
   }
   const T &get() const { return const_cast<ManagedObj *>(this)->get(); }
+  /// Return the ManagedObj that stores obj
+  static ManagedObj *fromObject(T *obj) {
+    return (ManagedObj *)((char *)obj - offsetof(ManagedObj, data));
+  }
 #ifndef NDEBUG
   ~ManagedObj() { assert(!is_constructed); }
 #endif
@@ -54,46 +58,53 @@ template <typename T> class ManagedGlobal {
   ManagedObj<T> data;
 
   std::atomic<uint32_t> ref_count = 0;
-  std::shared_mutex mtx;
+  /// Only taken on the 0 <-> 1 transitions of ref_count
+  std::mutex mtx;
 
   template <auto> friend class GlobalRefCount;
+  template <auto> friend class BiasedGlobalRefCount;
+  friend class GlobalInitializer;
   using value_type = T;
 
+  /// While ref_count > 0 the object is constructed and ref_count can't reach 0
+  /// without the mutex, so incrementing it is a single CAS.
   void init_or_inc_ref_count() {
-    {
-      std::shared_lock<std::shared_mutex> reader(mtx);
-      uint32_t count = ref_count;
-      if (count > 0 && ref_count.compare_exchange_strong(count, count + 1))
+    uint32_t count = ref_count.load(std::memory_order_relaxed);
+    while (count > 0)
+      if (ref_count.compare_exchange_weak(count, count + 1,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed))
         return;
-    }
-    std::lock_guard<std::shared_mutex> g(mtx);
-    if (ref_count > 0) {
-      ref_count++;
-      return;
-    }
-    data.construct();
-    ref_count++;
+    std::lock_guard<std::mutex> g(mtx);
+    // Nothing else can leave 0 while the mutex is held
+    if (ref_count.load(std::memory_order_relaxed) == 0)
+      data.construct();
+    ref_count.fetch_add(1, std::memory_order_release);
   }
 
+  /// Decrementing above 1 is a single CAS. Otherwise under the mutex a
+  /// concurrent increment can still happen, so only the thread that takes
+  /// ref_count from 1 to 0 destroys the object.
   void dec_ref_count_and_maybe_destroy() {
-    assert(ref_count > 0);
-    {
-      std::shared_lock<std::shared_mutex> reader(mtx);
-      uint32_t count = ref_count;
-      if (count > 1 && ref_count.compare_exchange_strong(count, count - 1))
+    uint32_t count = ref_count.load(std::memory_order_relaxed);
+    assert(count > 0);
+    while (count > 1)
+      if (ref_count.compare_exchange_weak(count, count - 1,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
         return;
-    }
-    std::lock_guard<std::shared_mutex> g(mtx);
-    if (ref_count > 1) {
-      ref_count--;
-      return;
-    }
-    data.destruct();
-    ref_count--;
+    std::lock_guard<std::mutex> g(mtx);
+    if (ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      data.destruct();
   }
 
   T &get() { return data.get(); }
   const T &get() const { return data.get(); }
+
+public:
+  /// Return true if the object is constructed. Creating a GlobalRefCount while
+  /// it is being constructed waits for the construction to finish.
+  bool is_ready() const { return ref_count.load(std::memory_order_acquire); }
 };
 
 /// Keep a global variable a live during its lifetime.
@@ -110,6 +121,59 @@ public:
   const T &get() const { return Global->get(); }
   GlobalRefCount() { Global->init_or_inc_ref_count(); }
   ~GlobalRefCount() { Global->dec_ref_count_and_maybe_destroy(); }
+  /// Return true if creating a GlobalRefCount would not construct the global
+  /// or wait for its construction
+  static bool is_ready() { return Global->is_ready(); }
+};
+
+/// Same as GlobalRefCount, but each thread only holds one reference on the
+/// ManagedGlobal and counts its holders locally, so creating and destroying
+/// holders never touches shared memory after the first one of the thread.
+/// The reference of a thread is released when the thread exits or when flush
+/// is called while it has no holder, so the global lives as long as a thread
+/// that used it hasn't done one of those.
+/// An object of this class must be destroyed by the thread that created it.
+template <auto Global> class BiasedGlobalRefCount {
+  using T = typename std::remove_pointer_t<decltype(Global)>::value_type;
+
+  struct ThreadRef {
+    uint32_t count = 0;
+    bool registered = false;
+    ~ThreadRef() {
+      assert(count == 0 && "holder outlives its thread");
+      if (registered)
+        Global->dec_ref_count_and_maybe_destroy();
+    }
+  };
+  static ThreadRef &getThreadRef() {
+    thread_local ThreadRef ref;
+    return ref;
+  }
+
+public:
+  T &get() { return Global->get(); }
+  const T &get() const { return Global->get(); }
+  BiasedGlobalRefCount() {
+    ThreadRef &ref = getThreadRef();
+    if (!ref.registered) {
+      Global->init_or_inc_ref_count();
+      ref.registered = true;
+    }
+    ref.count++;
+  }
+  ~BiasedGlobalRefCount() {
+    assert(getThreadRef().count > 0 && "destroyed by another thread");
+    getThreadRef().count--;
+  }
+
+  /// Release the reference of the current thread if it has no holder left
+  static void flush() {
+    ThreadRef &ref = getThreadRef();
+    if (ref.count == 0 && ref.registered) {
+      ref.registered = false;
+      Global->dec_ref_count_and_maybe_destroy();
+    }
+  }
 };
 
 } // namespace sigta
@@ -3,6 +3,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
 
 namespace sigta {
 namespace meta {
@@ -39,37 +42,193 @@ struct get_first {
   using type = First;
 };
 
-template <template <typename> typename, typename...>
-struct for_all {
-  static constexpr bool value = true;
+/// All the utilities below are flat: they are built on fold expressions and
+/// std::index_sequence instead of recursion, so a list of N types
+/// instantiates O(1) nested templates instead of O(N).
+
+template <typename... Tys>
+struct type_list {
+  static constexpr std::size_t size = sizeof...(Tys);
 };
 
-template <template <typename> typename Pred, typename First, typename... Others>
-struct for_all<Pred, First, Others...> {
-  static constexpr bool value =
-      Pred<First>::value && for_all<Pred, Others...>::value;
+template <typename... Tys1, typename... Tys2>
+constexpr type_list<Tys1..., Tys2...> operator+(type_list<Tys1...>,
+                                                type_list<Tys2...>) {
+  return {};
+}
+
+/// type_list<Tys...>... -> type_list<all of Tys...>
+template <typename... Lists>
+struct concat {
+  using type = decltype((type_list<>{} + ... + Lists{}));
 };
 
-template <template <typename> typename, typename...>
-struct assert_for_all {
-  static constexpr bool value = true;
+template <typename... Lists>
+using concat_t = typename concat<Lists...>::type;
+
+/// Template<Tys...> from type_list<Tys...>
+template <template <typename...> typename Template, typename List>
+struct apply;
+
+template <template <typename...> typename Template, typename... Tys>
+struct apply<Template, type_list<Tys...>> {
+  using type = Template<Tys...>;
 };
 
-template <template <typename> typename Pred, typename First, typename... Others>
-struct assert_for_all<Pred, First, Others...>
-    : assert_for_all<Pred, Others...> {
-  static_assert(Pred<First>::value, "failed on this element");
+template <template <typename...> typename Template, typename List>
+using apply_t = typename apply<Template, List>::type;
+
+namespace detail {
+
+template <std::size_t I, typename T>
+struct indexed {
+  using type = T;
 };
 
-template <template <typename> typename, typename...>
-struct for_any {
-  static constexpr bool value = false;
+template <typename SeqTy, typename... Tys>
+struct indexed_list;
+
+template <std::size_t... Is, typename... Tys>
+struct indexed_list<std::index_sequence<Is...>, Tys...> : indexed<Is, Tys>... {
+};
+
+/// Overload resolution picks the only base with the matching index.
+template <std::size_t I, typename T>
+indexed<I, T> select(const indexed<I, T>&);
+
+/// Deduction only succeeds if T is the type of exactly one base, which lets
+/// the compiler do the lookup instead of instantiating a comparison per
+/// element.
+template <typename T, std::size_t I>
+std::integral_constant<std::size_t, I> index_of(const indexed<I, T>&);
+
+template <typename T, typename ListTy, typename = void>
+struct unique_index {
+  static constexpr bool found = false;
+};
+
+template <typename T, typename ListTy>
+struct unique_index<
+    T, ListTy, std::void_t<decltype(index_of<T>(std::declval<ListTy>()))>> {
+  static constexpr bool found = true;
+  static constexpr std::size_t value =
+      decltype(index_of<T>(std::declval<ListTy>()))::value;
+};
+
+template <typename T, typename... Tys>
+constexpr std::size_t find() {
+  using Unique =
+      unique_index<T, indexed_list<std::index_sequence_for<Tys...>, Tys...>>;
+  if constexpr (Unique::found) {
+    return Unique::value;
+  } else {
+    constexpr bool matches[] = {std::is_same_v<T, Tys>..., false};
+    for (std::size_t idx = 0; idx < sizeof...(Tys); idx++)
+      if (matches[idx])
+        return idx;
+    return sizeof...(Tys);
+  }
+}
+
+template <typename... Tys>
+constexpr bool is_unique() {
+  using ListTy = indexed_list<std::index_sequence_for<Tys...>, Tys...>;
+  return (unique_index<Tys, ListTy>::found && ...);
+}
+
+/// order[I] is the index in Tys of the I-th element of the stable sort by
+/// decreasing alignment.
+template <typename... Tys>
+struct alignment_order {
+  static constexpr std::size_t size = sizeof...(Tys);
+  std::size_t order[size + 1] = {};
+  constexpr alignment_order() {
+    constexpr std::size_t aligns[] = {alignof(Tys)..., 0};
+    for (std::size_t idx = 0; idx < size; idx++) {
+      std::size_t rank = 0;
+      for (std::size_t other = 0; other < size; other++)
+        if (aligns[other] > aligns[idx] ||
+            (aligns[other] == aligns[idx] && other < idx))
+          rank++;
+      order[rank] = idx;
+    }
+  }
 };
 
-template <template <typename> typename Pred, typename First, typename... Others>
-struct for_any<Pred, First, Others...> {
-  static constexpr bool value =
-      Pred<First>::value || for_any<Pred, Others...>::value;
+template <typename SeqTy, typename... Tys>
+struct sort_by_alignment;
+
+template <std::size_t... Is, typename... Tys>
+struct sort_by_alignment<std::index_sequence<Is...>, Tys...> {
+  static constexpr alignment_order<Tys...> sorted{};
+  using type = type_list<typename decltype(select<sorted.order[Is]>(
+      indexed_list<std::index_sequence_for<Tys...>, Tys...>{}))::type...>;
+};
+
+template <template <typename> typename Pred, typename T>
+constexpr bool assert_one() {
+  static_assert(Pred<T>::value, "failed on this element");
+  return true;
+}
+
+} // namespace detail
+
+/// The I-th type of Tys.
+template <std::size_t I, typename... Tys>
+struct at {
+  static_assert(I < sizeof...(Tys), "index out of bounds");
+  using type = typename decltype(detail::select<I>(
+      detail::indexed_list<std::index_sequence_for<Tys...>, Tys...>{}))::type;
+};
+
+template <std::size_t I, typename... Tys>
+using at_t = typename at<I, Tys...>::type;
+
+/// Index of the first T in Tys or sizeof...(Tys) if there is none.
+template <typename T, typename... Tys>
+constexpr std::size_t find_v = detail::find<T, Tys...>();
+
+template <typename T, typename... Tys>
+constexpr bool contains_v = find_v<T, Tys...> != sizeof...(Tys);
+
+template <typename... Tys>
+constexpr bool is_unique_v = detail::is_unique<Tys...>();
+
+/// type_list of the Tys for which Pred holds, in order.
+template <template <typename> typename Pred, typename... Tys>
+struct filter {
+  using type = concat_t<
+      std::conditional_t<Pred<Tys>::value, type_list<Tys>, type_list<>>...>;
+};
+
+template <template <typename> typename Pred, typename... Tys>
+using filter_t = typename filter<Pred, Tys...>::type;
+
+/// type_list of Tys stably sorted by decreasing alignment, this is the order
+/// that minimizes padding.
+template <typename... Tys>
+struct sort_by_alignment {
+  using type = typename detail::sort_by_alignment<
+      std::index_sequence_for<Tys...>, Tys...>::type;
+};
+
+template <typename... Tys>
+using sort_by_alignment_t = typename sort_by_alignment<Tys...>::type;
+
+template <template <typename> typename Pred, typename... Tys>
+struct for_all {
+  static constexpr bool value = (Pred<Tys>::value && ...);
+};
+
+template <template <typename> typename Pred, typename... Tys>
+struct assert_for_all {
+  static_assert((detail::assert_one<Pred, Tys>() && ...));
+  static constexpr bool value = true;
+};
+
+template <template <typename> typename Pred, typename... Tys>
+struct for_any {
+  static constexpr bool value = (Pred<Tys>::value || ...);
 };
 
 template <template <typename> typename Pred, typename... Tys>
@@ -82,47 +241,35 @@ constexpr T align_up(T value, T align) {
   return ((value + (align - 1)) / align) * align;
 }
 
-template <typename...>
-struct Layout {};
-
-template <typename FirstComp, typename... CompTys>
-struct Layout<FirstComp, CompTys...> {
+template <typename... CompTys>
+struct Layout {
   static constexpr std::size_t getSize(std::size_t counter = 0) {
-    return Layout<CompTys...>::getSize(
-        align_up(counter + sizeof(FirstComp), alignof(FirstComp)));
+    constexpr std::size_t sizes[] = {sizeof(CompTys)..., 0};
+    constexpr std::size_t aligns[] = {alignof(CompTys)..., 1};
+    for (std::size_t idx = 0; idx < sizeof...(CompTys); idx++)
+      counter = align_up(counter + sizes[idx], aligns[idx]);
+    return std::max<std::size_t>(counter, 1);
   }
   static constexpr std::size_t getAlign() {
-    return std::max(alignof(FirstComp), Layout<CompTys...>::getAlign());
-  }
-  template <typename CompTy>
-  static constexpr bool has() {
-    return std::is_same_v<FirstComp, CompTy> ||
-           Layout<CompTys...>::template has<CompTy>();
-  }
-  template <typename CompTy>
-  static constexpr std::size_t getOffset(std::size_t counter = 0) {
-    if constexpr (std::is_same_v<FirstComp, CompTy>)
-      return align_up(counter, alignof(FirstComp));
-    else
-      return Layout<CompTys...>::template getOffset<CompTy>(
-          align_up(counter + sizeof(FirstComp), alignof(FirstComp)));
-  }
-};
-
-template <>
-struct Layout<> {
-  static constexpr std::size_t getSize(std::size_t counter = 0) {
-    return std::max<std::size_t>(counter, 1);
+    return std::max({std::size_t(1), alignof(CompTys)...});
   }
-  static constexpr std::size_t getAlign() { return 1; }
   template <typename CompTy>
   static constexpr bool has() {
-    return false;
+    return contains_v<CompTy, CompTys...>;
   }
   template <typename CompTy>
   static constexpr std::size_t getOffset(std::size_t counter = 0) {
-    assert(false && "cant ecs_get an offset for a component that doesnt exist");
-    return 0;
+    constexpr std::size_t sizes[] = {sizeof(CompTys)..., 0};
+    constexpr std::size_t aligns[] = {alignof(CompTys)..., 1};
+    constexpr std::size_t pos = find_v<CompTy, CompTys...>;
+    if (pos == sizeof...(CompTys)) {
+      assert(false &&
+             "cant ecs_get an offset for a component that doesnt exist");
+      return 0;
+    }
+    for (std::size_t idx = 0; idx < pos; idx++)
+      counter = align_up(counter + sizes[idx], aligns[idx]);
+    return align_up(counter, aligns[pos]);
   }
 };
 
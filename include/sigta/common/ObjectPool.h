@@ -0,0 +1,224 @@
+//===----------------------------------------------------------------------===//
+// Provide ObjectPool, a pool of ManagedObj slots for objects that are created
+// and destroyed at a high rate.
+//
+// Slots are allocated by slabs and never returned to the system before the
+// pool is destroyed. Each thread has a cache of free slots, so most creations
+// and destructions touch no shared memory. Caches exchange slots with a
+// shared list by batches, under a mutex.
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_OBJECT_POOL_H
+#define SIGTA_COMMON_OBJECT_POOL_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "sigta/common/ManagedObjs.h"
+
+namespace sigta {
+
+namespace pool_detail {
+
+/// Small index unique among running threads, reused after a thread exits
+class ThreadIndex {
+  std::mutex mtx;
+  std::vector<unsigned> freeIndexes;
+  unsigned next = 0;
+
+  static ThreadIndex& getRegistry() {
+    static ThreadIndex registry;
+    return registry;
+  }
+
+  struct Holder {
+    unsigned index;
+    Holder() {
+      ThreadIndex& r = getRegistry();
+      std::lock_guard<std::mutex> g(r.mtx);
+      if (r.freeIndexes.empty()) {
+        index = r.next++;
+      } else {
+        index = r.freeIndexes.back();
+        r.freeIndexes.pop_back();
+      }
+    }
+    ~Holder() {
+      ThreadIndex& r = getRegistry();
+      std::lock_guard<std::mutex> g(r.mtx);
+      r.freeIndexes.push_back(index);
+    }
+  };
+
+public:
+  static unsigned get() {
+    thread_local Holder holder;
+    return holder.index;
+  }
+};
+
+} // namespace pool_detail
+
+/// Pool of T. create and destroy can be executed concurrently, an object can
+/// be destroyed by another thread than the one that created it.
+/// The first CacheCount threads get their own cache, the others share the
+/// list of free slots of the pool.
+/// Every object must be destroyed before the pool.
+template <typename T, std::size_t BatchSize = 32, std::size_t SlabSize = 256,
+          std::size_t CacheCount = 64>
+class ObjectPool {
+  static_assert(SlabSize % BatchSize == 0,
+                "slabs are split in batches of free slots");
+
+  struct Slot {
+    ManagedObj<T> obj;
+    Slot* next;
+  };
+
+  /// Counters are only written by the thread that owns the cache, but can be
+  /// read by getStats
+  struct alignas(64) Cache {
+    Slot* head = nullptr;
+    std::size_t count = 0;
+    std::atomic<std::size_t> created = 0;
+    std::atomic<std::size_t> destroyed = 0;
+
+    void bump(std::atomic<std::size_t>& counter) {
+      counter.store(counter.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+  };
+
+  std::unique_ptr<Cache[]> caches;
+  std::mutex mtx;
+  /// Each batch is a list of BatchSize slots
+  std::vector<Slot*> batches;
+  std::vector<std::unique_ptr<Slot[]>> slabs;
+  /// Slots used by threads without a cache, must hold mtx
+  Slot* sharedHead = nullptr;
+  std::size_t sharedCreated = 0;
+  std::size_t sharedDestroyed = 0;
+
+  /// Must hold mtx
+  void allocateSlab() {
+    slabs.emplace_back(new Slot[SlabSize]);
+    Slot* slab = slabs.back().get();
+    for (std::size_t idx = 0; idx < SlabSize; idx += BatchSize) {
+      for (std::size_t elem = idx; elem + 1 < idx + BatchSize; elem++)
+        slab[elem].next = &slab[elem + 1];
+      slab[idx + BatchSize - 1].next = nullptr;
+      batches.push_back(&slab[idx]);
+    }
+  }
+
+  /// Must hold mtx
+  Slot* popBatch() {
+    if (batches.empty())
+      allocateSlab();
+    Slot* res = batches.back();
+    batches.pop_back();
+    return res;
+  }
+
+  Cache* getCache() {
+    unsigned index = pool_detail::ThreadIndex::get();
+    return index < CacheCount ? &caches[index] : nullptr;
+  }
+
+  static Slot* getSlot(T* obj) {
+    return reinterpret_cast<Slot*>(ManagedObj<T>::fromObject(obj));
+  }
+
+  Slot* allocate() {
+    Cache* cache = getCache();
+    if (!cache) {
+      std::lock_guard<std::mutex> g(mtx);
+      if (!sharedHead)
+        sharedHead = popBatch();
+      sharedCreated++;
+      return std::exchange(sharedHead, sharedHead->next);
+    }
+    if (!cache->head) {
+      std::lock_guard<std::mutex> g(mtx);
+      cache->head = popBatch();
+      cache->count = BatchSize;
+    }
+    cache->bump(cache->created);
+    cache->count--;
+    return std::exchange(cache->head, cache->head->next);
+  }
+
+  void deallocate(Slot* slot) {
+    Cache* cache = getCache();
+    if (!cache) {
+      std::lock_guard<std::mutex> g(mtx);
+      slot->next = sharedHead;
+      sharedHead = slot;
+      sharedDestroyed++;
+      return;
+    }
+    cache->bump(cache->destroyed);
+    slot->next = cache->head;
+    cache->head = slot;
+    // Keep up to 2 batches so alternating creations and destructions don't
+    // go to the shared list every time
+    if (++cache->count < 2 * BatchSize)
+      return;
+    Slot* batch = cache->head;
+    Slot* last = batch;
+    for (std::size_t idx = 1; idx < BatchSize; idx++)
+      last = last->next;
+    cache->head = last->next;
+    last->next = nullptr;
+    cache->count -= BatchSize;
+    std::lock_guard<std::mutex> g(mtx);
+    batches.push_back(batch);
+  }
+
+public:
+  struct Stats {
+    std::size_t slabs;
+    /// Number of slots
+    std::size_t capacity;
+    /// Number of objects alive
+    std::size_t live;
+  };
+
+  ObjectPool() : caches(new Cache[CacheCount]) {}
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  template <typename... Ts>
+  T* create(Ts&&... ts) {
+    Slot* slot = allocate();
+    slot->obj.construct(std::forward<Ts>(ts)...);
+    return &slot->obj.get();
+  }
+
+  /// obj must have been created by this pool
+  void destroy(T* obj) {
+    Slot* slot = getSlot(obj);
+    slot->obj.destruct();
+    deallocate(slot);
+  }
+
+  /// Only exact when no create or destroy is running concurrently
+  Stats getStats() {
+    std::lock_guard<std::mutex> g(mtx);
+    Stats res{slabs.size(), slabs.size() * SlabSize,
+              sharedCreated - sharedDestroyed};
+    for (std::size_t idx = 0; idx < CacheCount; idx++)
+      res.live += caches[idx].created.load(std::memory_order_relaxed) -
+                  caches[idx].destroyed.load(std::memory_order_relaxed);
+    return res;
+  }
+};
+
+} // namespace sigta
+
+#endif
@@ -5,22 +5,98 @@
 #ifndef SIGTA_COMMON_RTTI_H
 #define SIGTA_COMMON_RTTI_H
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
 
 #include "sigta/common/Extras.h"
 
 namespace sigta {
 namespace rtti {
 
+/// Return the name of Ty as written by the compiler. It doesn't depend on the
+/// build or link order so it can be used to identify a type across builds made
+/// with the same compiler.
+template <typename Ty>
+constexpr std::string_view typeName() {
+  std::string_view name = __PRETTY_FUNCTION__;
+  std::size_t start = name.find("Ty = ") + 5;
+  std::size_t end = name.find_first_of(";]", start);
+  return name.substr(start, end - start);
+}
+
+/// Hash of the name of Ty
+template <typename Ty>
+constexpr uint64_t typeHash() {
+  return extra::hashBytes(typeName<Ty>());
+}
+
+/// Associate the type with a name hash to the ID it got in a build. A list of
+/// those is a manifest that can be stored alongside data keyed by type IDs.
+struct ManifestEntry {
+  uint64_t hash;
+  uint64_t id;
+};
+
+/// Translate IDs from a build into IDs of another build using their
+/// manifests. Translating is a single lookup in a table indexed by ID.
+template <typename IDTy>
+class IDRemapper {
+  std::vector<IDTy> table;
+  uint64_t base = 0;
+
+public:
+  static constexpr IDTy invalid = std::numeric_limits<IDTy>::max();
+
+  IDRemapper(const std::vector<ManifestEntry>& from,
+             const std::vector<ManifestEntry>& to) {
+    std::vector<ManifestEntry> sortedTo = to;
+    std::sort(sortedTo.begin(), sortedTo.end(),
+              [](ManifestEntry l, ManifestEntry r) { return l.hash < r.hash; });
+    assert(std::adjacent_find(sortedTo.begin(), sortedTo.end(),
+                              [](ManifestEntry l, ManifestEntry r) {
+                                return l.hash == r.hash;
+                              }) == sortedTo.end() &&
+           "type name hash collision");
+    if (from.empty())
+      return;
+    auto [min, max] = std::minmax_element(
+        from.begin(), from.end(),
+        [](ManifestEntry l, ManifestEntry r) { return l.id < r.id; });
+    base = min->id;
+    table.assign(max->id - base + 1, invalid);
+    for (ManifestEntry entry : from) {
+      auto it = std::lower_bound(
+          sortedTo.begin(), sortedTo.end(), entry.hash,
+          [](ManifestEntry l, uint64_t hash) { return l.hash < hash; });
+      if (it != sortedTo.end() && it->hash == entry.hash)
+        table[entry.id - base] = (IDTy)it->id;
+    }
+  }
+
+  /// Return the ID in the new build or invalid if the type doesn't exist there
+  IDTy remap(IDTy id) const {
+    uint64_t idx = (uint64_t)id - base;
+    return idx < table.size() ? table[idx] : invalid;
+  }
+};
+
 /// Generate a Linearly increasing ID for each type
 /// expects a UniquerTy to create a category of IDs
 /// This enables having mutiple LinearID in the same program
 /// That share the same value range
-template <typename UniquerTy, typename IDTy = uint16_t, IDTy Start = 0>
-class LinearID
-    : public extra::EquallyComparable<LinearID<UniquerTy, IDTy, Start>> {
+/// When Stable is true IDs are assigned by order of typeHash instead of order
+/// of static initialization, so they are the same across builds containing
+/// the same types. In this mode init() must be called inside main before
+/// getting any IDs.
+template <typename UniquerTy, typename IDTy = uint16_t, IDTy Start = 0,
+          bool Stable = false>
+class LinearID : public extra::EquallyComparable<
+                     LinearID<UniquerTy, IDTy, Start, Stable>> {
   IDTy ID;
 
   LinearID(IDTy id) : ID(id) {}
@@ -34,34 +110,83 @@ class LinearID
     return count;
   }
 
-  template <typename Ty>
-  struct initT {
+  struct Entry {
     IDTy id;
+    uint64_t hash;
+    Entry* next;
+  };
+  static Entry*& entries() {
+    static Entry* head = nullptr;
+    return head;
+  }
+
+  static void freeze() {
+#ifndef NDEBUG
+    if constexpr (Stable)
+      assert(isFrozen && "used before it is ready");
+    else
+      isFrozen = true;
+#endif
+  }
+
+  template <typename Ty>
+  struct initT : Entry {
     initT() {
       assert(!isFrozen && "accessed before initialization was done");
-      id = internalCount()++;
+      this->id = internalCount()++;
+      this->hash = typeHash<Ty>();
+      this->next = entries();
+      entries() = this;
     }
   };
   template <typename Ty>
-  static inline initT<Ty> init;
+  static inline initT<Ty> registration;
 
 public:
   LinearID(const LinearID&) = default;
-  static IDTy countIDs() { return {maxID().ID - Start}; }
+  static IDTy countIDs() { return (IDTy)(maxID().ID - Start); }
 
-  static LinearID maxID() {
+  /// Assign IDs in Stable mode, does nothing otherwise
+  static void init() {
+    if constexpr (Stable) {
+      assert(!isFrozen && "already initialized");
+      extra::assertSingleThread<LinearID>();
 #ifndef NDEBUG
-    isFrozen = true;
+      isFrozen = true;
 #endif
+      std::vector<Entry*> sorted;
+      for (Entry* e = entries(); e; e = e->next)
+        sorted.push_back(e);
+      std::sort(sorted.begin(), sorted.end(),
+                [](Entry* l, Entry* r) { return l->hash < r->hash; });
+      for (std::size_t idx = 0; idx < sorted.size(); idx++) {
+        assert((idx == 0 || sorted[idx - 1]->hash != sorted[idx]->hash) &&
+               "type name hash collision");
+        sorted[idx]->id = (IDTy)(Start + idx);
+      }
+    }
+  }
+
+  static LinearID maxID() {
+    freeze();
     return {internalCount()};
   }
 
   template <typename Ty>
   static LinearID get() {
-#ifndef NDEBUG
-    isFrozen = true;
-#endif
-    return {init<Ty>.id};
+    freeze();
+    return {registration<Ty>.id};
+  }
+
+  /// Return the hash and ID of every type
+  static std::vector<ManifestEntry> getManifest() {
+    freeze();
+    std::vector<ManifestEntry> res;
+    for (Entry* e = entries(); e; e = e->next)
+      res.push_back({e->hash, e->id});
+    std::sort(res.begin(), res.end(),
+              [](ManifestEntry l, ManifestEntry r) { return l.id < r.id; });
+    return res;
   }
 
   IDTy getInt() const { return ID; }
@@ -80,14 +205,19 @@ public:
     static int64_t id;
     return {&id};
   }
+  uintptr_t getInt() const { return (uintptr_t)ID; }
   bool operator==(UniqueID Other) const { return ID == Other.ID; }
 };
 
 /// Generate IDs suitable to be used to identify members of a Hierarchy
 /// expects a BaseTy, it is used to identify the Hierarchy
-template <typename BaseTy, typename IDTy = uint16_t, IDTy start = 0>
-class HierarchyID
-    : public extra::EquallyComparable<HierarchyID<BaseTy, IDTy, start>> {
+/// When Stable is true siblings are ordered by typeHash instead of order of
+/// static initialization, so IDs are the same across builds containing the
+/// same hierarchy.
+template <typename BaseTy, typename IDTy = uint16_t, IDTy start = 0,
+          bool Stable = false>
+class HierarchyID : public extra::EquallyComparable<
+                        HierarchyID<BaseTy, IDTy, start, Stable>> {
   IDTy ID;
 
   HierarchyID(IDTy p) : ID(p) {}
@@ -96,24 +226,32 @@ class HierarchyID
   static inline bool isFrozen{false};
 #endif
 
-  union Node {
-    struct A {
-      IDTy min;
-      IDTy max;
-    } id;
-    struct B {
-      Node* child;
-      Node* next;
-    } graph;
+  struct Node;
+  struct IDs {
+    IDTy min;
+    IDTy max;
+  };
+  struct Links {
+    Node* child;
+    Node* next;
+  };
+  struct Node {
+    union {
+      IDs id;
+      Links graph;
+    };
+    uint64_t hash;
   };
 
   template <typename Ty>
   static inline Node data;
 
   /// marked noinline to prevent template bloat
-  static __attribute__((noinline)) void buildGraph(Node* self, Node* parent) {
+  static __attribute__((noinline)) void buildGraph(Node* self, Node* parent,
+                                                   uint64_t hash) {
     assert(!isFrozen);
     extra::assertSingleThread<HierarchyID>();
+    self->hash = hash;
     Node** addr = &parent->graph.child;
     while (*addr)
       addr = &(*addr)->graph.next;
@@ -126,24 +264,53 @@ class HierarchyID
     initT() {
       Node* parent = &data<ParentTy>;
       Node* self = &data<Ty>;
-      buildGraph(self, parent);
+      buildGraph(self, parent, typeHash<Ty>());
     }
   };
 
   template <typename Ty, typename ParentTy>
   static inline initT<Ty, ParentTy> graphBuilder;
 
+  static std::vector<ManifestEntry>& manifest() {
+    static std::vector<ManifestEntry> res;
+    return res;
+  }
+
   static void recursiveIDBuilder(Node* n, IDTy& id) {
     if (!n)
       return;
     Node* child = n->graph.child;
+    manifest().push_back({n->hash, id});
     n->id.min = id++;
     recursiveIDBuilder(child, id);
     n->id.max = id;
     recursiveIDBuilder(n->graph.next, id);
   }
 
+  static void recursiveSortByHash(Node* n) {
+    std::vector<Node*> children;
+    for (Node* child = n->graph.child; child; child = child->graph.next)
+      children.push_back(child);
+    std::sort(children.begin(), children.end(),
+              [](Node* l, Node* r) { return l->hash < r->hash; });
+    Node** addr = &n->graph.child;
+    for (Node* child : children) {
+      *addr = child;
+      addr = &child->graph.next;
+      recursiveSortByHash(child);
+    }
+    *addr = nullptr;
+  }
+
 public:
+  /// The half-open range [min, max) of IDs covered by a class and all of its
+  /// subclasses
+  struct Range {
+    IDTy min;
+    IDTy max;
+    bool contains(HierarchyID id) const { return id.ID >= min && id.ID < max; }
+  };
+
   HierarchyID() = default;
 
   /// Must be called inside main before getting any IDs
@@ -154,6 +321,9 @@ public:
     isFrozen = true;
 #endif
     Node* root = &data<BaseTy>;
+    root->hash = typeHash<BaseTy>();
+    if constexpr (Stable)
+      recursiveSortByHash(root);
     IDTy id = start;
     recursiveIDBuilder(root, id);
   }
@@ -168,6 +338,7 @@ public:
     }
   };
 
+  static HierarchyID minID() { return {start}; }
   static HierarchyID maxID() { return {data<BaseTy>.id.max}; }
 
   /// Return an HierarchyID for the Ty
@@ -177,6 +348,20 @@ public:
     return {data<Ty>.id.min};
   }
 
+  /// Return the hash and ID of every class of the hierarchy
+  static const std::vector<ManifestEntry>& getManifest() {
+    assert(isFrozen && "used before it is ready");
+    return manifest();
+  }
+
+  /// Return the range of IDs used by Ty and its subclasses
+  template <typename Ty>
+  static Range getRange() {
+    assert(isFrozen && "used before it is ready");
+    Node* n = &data<Ty>;
+    return {n->id.min, n->id.max};
+  }
+
   /// Return true if the class identified by id is Ty or one of its subclasses
   template <typename Ty>
   static bool isclassof(HierarchyID id) {
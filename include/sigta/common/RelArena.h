@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+// This file provides RelArena, a bump-pointer allocator for graphs of objects
+// linked by RelPtr.
+//
+// The arena reserves its whole address range upfront and never moves, so
+// allocations can be used through plain pointers while building. Its capacity
+// is bounded by the maximum of IntTy, so the offset between any two addresses
+// of the arena fits in a RelPtr<T, IntTy>. Once frozen, the arena is
+// read-only and its bytes can be copied, written to disk or moved as a unit.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_RELARENA_H
+#define SIGTA_COMMON_RELARENA_H
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "sigta/common/Meta.h"
+#include "sigta/common/RelContainers.h"
+#include "sigta/common/RelPtr.h"
+
+namespace sigta {
+
+template <typename IntTy = int32_t>
+class RelArena {
+  static_assert(std::is_signed_v<IntTy>,
+                "RelPtr with an unsigned IntTy can't point backward");
+
+  char* base = nullptr;
+  std::size_t used = 0;
+  std::size_t capacity = 0;
+  bool isFrozen = false;
+  bool owned = true;
+
+public:
+  /// The maximum of IntTy is used by RelPtr as null, so the largest offset
+  /// must be smaller.
+  static constexpr std::size_t maxCapacity = std::numeric_limits<IntTy>::max();
+
+  static constexpr std::size_t defaultCapacity =
+      std::min<std::size_t>(maxCapacity, 1ull << 32);
+
+  template <typename T>
+  using Ptr = RelPtr<T, IntTy>;
+
+  /// Only reserves address space, pages are backed by memory when used
+  explicit RelArena(std::size_t cap = defaultCapacity) : capacity(cap) {
+    assert(capacity <= maxCapacity && "offsets wouldn't fit IntTy");
+    void* res = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (res == MAP_FAILED)
+      capacity = 0;
+    else
+      base = static_cast<char*>(res);
+  }
+  /// Allocate in cap bytes at mem, which stay owned by the caller
+  RelArena(char* mem, std::size_t cap)
+      : base(mem), capacity(cap), owned(false) {
+    assert(capacity <= maxCapacity && "offsets wouldn't fit IntTy");
+  }
+  RelArena(RelArena&& other)
+      : base(std::exchange(other.base, nullptr)),
+        used(std::exchange(other.used, 0)),
+        capacity(std::exchange(other.capacity, 0)),
+        isFrozen(other.isFrozen), owned(other.owned) {}
+  RelArena& operator=(RelArena&& other) {
+    std::swap(base, other.base);
+    std::swap(used, other.used);
+    std::swap(capacity, other.capacity);
+    std::swap(isFrozen, other.isFrozen);
+    std::swap(owned, other.owned);
+    return *this;
+  }
+  RelArena(const RelArena&) = delete;
+  RelArena& operator=(const RelArena&) = delete;
+  ~RelArena() {
+    if (base && owned)
+      munmap(base, capacity);
+  }
+
+  /// Return nullptr if the arena is full
+  void* allocate(std::size_t size, std::size_t align) {
+    assert(!isFrozen && "allocating in a frozen arena");
+    std::size_t offset = meta::align_up(used, align);
+    if (offset > capacity || capacity - offset < size)
+      return nullptr;
+    used = offset + size;
+    return base + offset;
+  }
+
+  /// The first object created is at the start of the arena, it can be used as
+  /// the root of the blob. Return nullptr if the arena is full.
+  template <typename T, typename... Ts>
+  T* create(Ts&&... ts) {
+    void* mem = allocate(sizeof(T), alignof(T));
+    return mem ? new (mem) T(std::forward<Ts>(ts)...) : nullptr;
+  }
+
+  /// Return nullptr if the arena is full
+  template <typename T>
+  T* createArray(std::size_t count) {
+    if (count > capacity / sizeof(T))
+      return nullptr;
+    T* res = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    if (res)
+      for (std::size_t idx = 0; idx < count; idx++)
+        new (res + idx) T();
+    return res;
+  }
+
+  /// The following functions lay out the containers of RelContainers.h, they
+  /// return false if the arena is full.
+
+  bool setString(RelString<IntTy>& str, std::string_view value) {
+    char* chars = createArray<char>(value.size() + 1);
+    if (!chars)
+      return false;
+    std::memcpy(chars, value.data(), value.size());
+    str.assign(chars, value.size());
+    return true;
+  }
+
+  template <typename T>
+  bool setSpan(RelSpan<T, IntTy>& span, std::size_t count) {
+    T* elems = createArray<T>(count);
+    if (elems)
+      span.assign(elems, count);
+    return elems;
+  }
+
+  template <typename T>
+  bool setVector(RelVector<T, IntTy>& vec, std::size_t cap) {
+    if (cap > capacity / sizeof(T))
+      return false;
+    T* storage = static_cast<T*>(allocate(sizeof(T) * cap, alignof(T)));
+    if (storage)
+      vec.assign(storage, cap);
+    return storage;
+  }
+
+  template <typename K, typename V, typename HashTy>
+  bool setHashMap(RelHashMap<K, V, IntTy, HashTy>& map, std::size_t count) {
+    using MapTy = RelHashMap<K, V, IntTy, HashTy>;
+    std::size_t cap = MapTy::getCapacityFor(count);
+    auto* slots = createArray<typename MapTy::Slot>(cap);
+    if (slots)
+      map.assign(slots, cap);
+    return slots;
+  }
+
+  /// Make the arena read-only, no more allocation can be done
+  void freeze() {
+    assert(!isFrozen && "already frozen");
+    isFrozen = true;
+    if (base)
+      mprotect(base, capacity, PROT_READ);
+  }
+
+  /// Return true if p points into the arena
+  bool contains(const void* p) const {
+    return p >= base && p < base + used;
+  }
+
+  char* data() { return base; }
+  const char* data() const { return base; }
+  std::size_t size() const { return used; }
+  std::size_t getCapacity() const { return capacity; }
+  bool frozen() const { return isFrozen; }
+};
+
+} // namespace sigta
+
+#endif // SIGTA_COMMON_RELARENA_H
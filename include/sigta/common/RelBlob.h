@@ -0,0 +1,416 @@
+//===----------------------------------------------------------------------===//
+//
+// This file provides a file format for blobs of RelPtr based data, with a
+// writer and a loader that maps the file read-only.
+//
+// Since a corrupted offset would make RelPtr::get point anywhere, the loader
+// checks a header (magic, version, size and checksum) and then validates the
+// blob according to a schema: every RelPtr, RelSpan, RelString... reachable
+// from the root must point inside the blob with correct alignment. After that,
+// the data is used in place with no copy and no extra checks.
+//
+// The schema of a type is given by specializing RelSchema, most of the time by
+// listing the members that need validation:
+//   template <> struct sigta::RelSchema<Node>
+//       : sigta::RelFields<&Node::next, &Node::name> {};
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_RELBLOB_H
+#define SIGTA_COMMON_RELBLOB_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sigta/common/Extras.h"
+#include "sigta/common/RelContainers.h"
+#include "sigta/common/RelPtr.h"
+
+namespace sigta {
+
+class RelValidator;
+
+/// Describe how to validate a T inside a blob. hasPointers is false when a T
+/// can't reference other memory, in which case only its bounds are checked.
+template <typename T, typename = void>
+struct RelSchema {
+  static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>,
+                "RelSchema should be specialized for this type");
+  static constexpr bool hasPointers = false;
+  static bool validate(RelValidator&, const T&) { return true; }
+};
+
+namespace relblob_detail {
+template <typename>
+struct MemberOf;
+template <typename ClassTy, typename MemberTy>
+struct MemberOf<MemberTy ClassTy::*> {
+  using type = MemberTy;
+};
+} // namespace relblob_detail
+
+/// Schema of a struct which needs its Members to be validated. Members not
+/// listed are not checked, so they must not reference memory.
+template <auto... Members>
+struct RelFields {
+  static constexpr bool hasPointers =
+      (RelSchema<typename relblob_detail::MemberOf<
+           decltype(Members)>::type>::hasPointers ||
+       ... || false);
+  template <typename T>
+  static bool validate(RelValidator& v, const T& obj);
+};
+
+/// Walk everything reachable from a root and check it stays inside the blob.
+/// Objects pointed to are processed from a worklist so long chains don't
+/// recurse, and each object is visited once per type so cycles terminate.
+/// Visited objects are recorded in a bitmap over the blob, so validation
+/// doesn't allocate per object.
+class RelValidator {
+  uintptr_t begin;
+  uintptr_t end;
+
+  using ValidateFn = bool (*)(RelValidator&, const char*, std::size_t);
+  struct Job {
+    ValidateFn fn;
+    const char* addr;
+    std::size_t count;
+  };
+  /// For one type, a bit per position aligned for the type in the blob, set
+  /// once the object at that position is scheduled
+  struct Visited {
+    ValidateFn fn;
+    std::vector<uint64_t> bits;
+  };
+  std::vector<Job> worklist;
+  /// Few types have pointers, so a linear search is enough
+  std::vector<Visited> visited;
+
+  std::vector<uint64_t>& getVisitedBits(ValidateFn fn, std::size_t align) {
+    for (Visited& v : visited)
+      if (v.fn == fn)
+        return v.bits;
+    std::size_t positions = (end - begin) / align + 2;
+    visited.push_back({fn, std::vector<uint64_t>((positions + 63) / 64)});
+    return visited.back().bits;
+  }
+
+  template <typename T>
+  static bool validateObjects(RelValidator& v, const char* addr,
+                              std::size_t count) {
+    const T* objs = reinterpret_cast<const T*>(addr);
+    for (std::size_t idx = 0; idx < count; idx++)
+      if (!RelSchema<T>::validate(v, objs[idx]))
+        return false;
+    return true;
+  }
+
+public:
+  RelValidator(const void* data, std::size_t size)
+      : begin((uintptr_t)data), end((uintptr_t)data + size) {}
+
+  /// Return true if count Ts starting at addr are inside the blob and addr is
+  /// correctly aligned
+  template <typename T>
+  bool inBounds(const T* addr, std::size_t count) const {
+    uintptr_t start = (uintptr_t)addr;
+    if (start < begin || start > end || start % alignof(T) != 0)
+      return false;
+    return count <= (end - start) / sizeof(T);
+  }
+
+  /// Validate a field of an object already known to be in the blob
+  template <typename T>
+  bool check(const T& field) {
+    return RelSchema<T>::validate(*this, field);
+  }
+
+  /// Validate count Ts starting at addr. The content is validated later if it
+  /// can contain pointers.
+  template <typename T>
+  bool checkObjects(const T* addr, std::size_t count) {
+    if (!inBounds(addr, count))
+      return false;
+    if constexpr (RelSchema<T>::hasPointers) {
+      // Schedule the runs of objects not scheduled yet
+      std::vector<uint64_t>& bits =
+          getVisitedBits(&validateObjects<T>, alignof(T));
+      uintptr_t alignedBegin = begin & ~(uintptr_t)(alignof(T) - 1);
+      std::size_t first = ((uintptr_t)addr - alignedBegin) / alignof(T);
+      constexpr std::size_t stride = sizeof(T) / alignof(T);
+      std::size_t runStart = count;
+      for (std::size_t idx = 0; idx < count; idx++) {
+        std::size_t bit = first + idx * stride;
+        uint64_t mask = uint64_t(1) << (bit % 64);
+        if (!(bits[bit / 64] & mask)) {
+          bits[bit / 64] |= mask;
+          if (runStart == count)
+            runStart = idx;
+          continue;
+        }
+        if (runStart != count)
+          worklist.push_back({&validateObjects<T>,
+                              reinterpret_cast<const char*>(addr + runStart),
+                              idx - runStart});
+        runStart = count;
+      }
+      if (runStart != count)
+        worklist.push_back({&validateObjects<T>,
+                            reinterpret_cast<const char*>(addr + runStart),
+                            count - runStart});
+    }
+    return true;
+  }
+
+  /// Validate everything reachable from a RootTy at the start of the blob
+  template <typename RootTy>
+  bool run() {
+    if (!checkObjects(reinterpret_cast<const RootTy*>(begin), 1))
+      return false;
+    while (!worklist.empty()) {
+      Job job = worklist.back();
+      worklist.pop_back();
+      if (!job.fn(*this, job.addr, job.count))
+        return false;
+    }
+    return true;
+  }
+};
+
+template <auto... Members>
+template <typename T>
+bool RelFields<Members...>::validate(RelValidator& v, const T& obj) {
+  return (v.check(obj.*Members) && ... && true);
+}
+
+template <typename T, typename IntTy, typename TraitTy>
+struct RelSchema<RelPtr<T, IntTy, TraitTy>> {
+  static constexpr bool hasPointers = true;
+  static bool validate(RelValidator& v,
+                       const RelPtr<T, IntTy, TraitTy>& ptr) {
+    return !ptr.get() || v.checkObjects(ptr.get(), 1);
+  }
+};
+
+template <typename T, unsigned TagBits, typename IntTy>
+struct RelSchema<TaggedRelPtr<T, TagBits, IntTy>> {
+  static constexpr bool hasPointers = true;
+  static bool validate(RelValidator& v,
+                       const TaggedRelPtr<T, TagBits, IntTy>& ptr) {
+    return !ptr.get() || v.checkObjects(ptr.get(), 1);
+  }
+};
+
+template <typename T, typename IntTy>
+struct RelSchema<RelSpan<T, IntTy>> {
+  static constexpr bool hasPointers = true;
+  static bool validate(RelValidator& v, const RelSpan<T, IntTy>& span) {
+    return span.empty() || v.checkObjects(span.data(), span.size());
+  }
+};
+
+template <typename T, typename IntTy>
+struct RelSchema<RelVector<T, IntTy>> {
+  static constexpr bool hasPointers = true;
+  static bool validate(RelValidator& v, const RelVector<T, IntTy>& vec) {
+    return vec.size() <= vec.capacity() &&
+           RelSchema<RelSpan<T, IntTy>>::validate(v, vec);
+  }
+};
+
+template <typename IntTy>
+struct RelSchema<RelString<IntTy>> {
+  static constexpr bool hasPointers = true;
+  static bool validate(RelValidator& v, const RelString<IntTy>& str) {
+    if (!str.data())
+      return str.empty();
+    return v.checkObjects(str.data(), str.size() + 1) &&
+           str.data()[str.size()] == '\0';
+  }
+};
+
+template <typename K, typename V, typename IntTy, typename HashTy>
+struct RelSchema<RelHashMap<K, V, IntTy, HashTy>> {
+  static constexpr bool hasPointers = true;
+  static bool validate(RelValidator& v,
+                       const RelHashMap<K, V, IntTy, HashTy>& map) {
+    auto& slots = map.getSlots();
+    if (slots.empty())
+      return map.empty();
+    if ((slots.size() & (slots.size() - 1)) != 0 ||
+        !v.inBounds(slots.data(), slots.size()))
+      return false;
+    std::size_t used = 0;
+    for (auto& slot : slots) {
+      if (slot.Ctrl == 0)
+        continue;
+      used++;
+      if (!v.check(slot.key) || !v.check(slot.value))
+        return false;
+    }
+    // Lookups stop on an empty slot, so there must be one
+    return used == map.size() && used < slots.size();
+  }
+};
+
+/// Header at the start of a blob file, the root object follows it
+struct alignas(64) RelBlobHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t size;
+  uint64_t checksum;
+};
+
+/// Hash of size bytes of data, processing 4 words at a time
+inline uint64_t relBlobChecksum(const void* data, std::size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  uint64_t lanes[4] = {1, 2, 3, 4};
+  std::size_t idx = 0;
+  for (; idx + 32 <= size; idx += 32)
+    for (int lane = 0; lane < 4; lane++) {
+      uint64_t word;
+      std::memcpy(&word, bytes + idx + lane * 8, 8);
+      lanes[lane] = (lanes[lane] ^ word) * 0x9e3779b97f4a7c15;
+      lanes[lane] ^= lanes[lane] >> 29;
+    }
+  uint64_t res = size;
+  for (uint64_t lane : lanes)
+    res = extra::hashInt(res ^ lane);
+  for (; idx < size; idx++)
+    res = (res ^ (uint8_t)bytes[idx]) * 0x100000001b3;
+  return res;
+}
+
+/// Write a blob file containing a header followed by size bytes of data.
+/// Return false on error.
+inline bool writeRelBlob(const char* path, uint64_t magic, uint32_t version,
+                         const void* data, std::size_t size) {
+  RelBlobHeader header{};
+  header.magic = magic;
+  header.version = version;
+  header.headerSize = sizeof(RelBlobHeader);
+  header.size = size;
+  header.checksum = relBlobChecksum(data, size);
+  FILE* file = std::fopen(path, "wb");
+  if (!file)
+    return false;
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+            std::fwrite(data, 1, size, file) == size;
+  return (std::fclose(file) == 0) && ok;
+}
+
+enum class RelBlobStatus {
+  Ok,
+  OpenFailed,
+  MapFailed,
+  BadHeader,
+  BadMagic,
+  BadVersion,
+  BadChecksum,
+  BadPointer,
+};
+
+/// Read-only mapping of a blob file
+class RelBlob {
+  void* mapping = nullptr;
+  std::size_t mapSize = 0;
+
+  void unmap() {
+    if (mapping)
+      munmap(mapping, mapSize);
+    mapping = nullptr;
+    mapSize = 0;
+  }
+
+  const RelBlobHeader& getHeader() const {
+    return *static_cast<const RelBlobHeader*>(mapping);
+  }
+
+  template <typename RootTy>
+  RelBlobStatus check(uint64_t magic, uint32_t version) const {
+    const RelBlobHeader& header = getHeader();
+    if (header.headerSize != sizeof(RelBlobHeader) ||
+        header.size != mapSize - sizeof(RelBlobHeader))
+      return RelBlobStatus::BadHeader;
+    if (header.magic != magic)
+      return RelBlobStatus::BadMagic;
+    if (header.version != version)
+      return RelBlobStatus::BadVersion;
+    if (header.size < sizeof(RootTy))
+      return RelBlobStatus::BadHeader;
+    if (relBlobChecksum(data(), size()) != header.checksum)
+      return RelBlobStatus::BadChecksum;
+    if (!RelValidator(data(), size()).run<RootTy>())
+      return RelBlobStatus::BadPointer;
+    return RelBlobStatus::Ok;
+  }
+
+public:
+  RelBlob() = default;
+  RelBlob(RelBlob&& other)
+      : mapping(std::exchange(other.mapping, nullptr)),
+        mapSize(std::exchange(other.mapSize, 0)) {}
+  RelBlob& operator=(RelBlob&& other) {
+    std::swap(mapping, other.mapping);
+    std::swap(mapSize, other.mapSize);
+    return *this;
+  }
+  ~RelBlob() { unmap(); }
+
+  /// Map the file at path, check its header and validate everything reachable
+  /// from its root as a RootTy. On failure nothing stays mapped.
+  template <typename RootTy>
+  RelBlobStatus open(const char* path, uint64_t magic, uint32_t version) {
+    static_assert(alignof(RootTy) <= alignof(RelBlobHeader),
+                  "root is over-aligned");
+    unmap();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      return RelBlobStatus::OpenFailed;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(RelBlobHeader)) {
+      ::close(fd);
+      return RelBlobStatus::BadHeader;
+    }
+    void* res = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (res == MAP_FAILED)
+      return RelBlobStatus::MapFailed;
+    mapping = res;
+    mapSize = st.st_size;
+
+    RelBlobStatus status = check<RootTy>(magic, version);
+    if (status != RelBlobStatus::Ok)
+      unmap();
+    return status;
+  }
+
+  template <typename RootTy>
+  const RootTy* getRoot() const {
+    assert(mapping && "no blob loaded");
+    return reinterpret_cast<const RootTy*>(data());
+  }
+
+  const char* data() const {
+    return static_cast<const char*>(mapping) + sizeof(RelBlobHeader);
+  }
+  std::size_t size() const {
+    return mapping ? mapSize - sizeof(RelBlobHeader) : 0;
+  }
+};
+
+} // namespace sigta
+
+#endif // SIGTA_COMMON_RELBLOB_H
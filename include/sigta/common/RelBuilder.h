@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+// This file provides RelBuilder, it lays out objects and the containers of
+// RelContainers.h into a single buffer. Once built the buffer can be written
+// to a file, and after being read back or mapped the objects can be used in
+// place without any parsing.
+//
+// The buffer moves as it grows, so allocations are designated by offsets into
+// it. RelPtr between objects of the buffer are not affected by moves.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_RELBUILDER_H
+#define SIGTA_COMMON_RELBUILDER_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sigta/common/Meta.h"
+#include "sigta/common/RelContainers.h"
+
+namespace sigta {
+
+class RelBuilder {
+  std::vector<char> buffer;
+
+  std::size_t allocate(std::size_t size, std::size_t align) {
+    assert(align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ &&
+           "the buffer isn't aligned enough");
+    std::size_t offset = meta::align_up(buffer.size(), align);
+    buffer.resize(offset + size);
+    return offset;
+  }
+
+  template <typename>
+  struct IsRelString : std::false_type {};
+  template <typename IntTy>
+  struct IsRelString<RelString<IntTy>> : std::true_type {};
+
+public:
+  /// Designate an object of type T inside the buffer
+  template <typename T>
+  struct Ref {
+    std::size_t offset;
+  };
+
+  /// Return a pointer to the object, it is invalidated by the next allocation
+  template <typename T>
+  T* get(Ref<T> ref) {
+    return reinterpret_cast<T*>(buffer.data() + ref.offset);
+  }
+
+  /// Designate a member of an object of the buffer
+  template <typename T, typename U>
+  Ref<U> field(Ref<T> ref, U T::*member) {
+    char* addr = reinterpret_cast<char*>(&(get(ref)->*member));
+    return {static_cast<std::size_t>(addr - buffer.data())};
+  }
+
+  /// Designate the element idx of an array of the buffer
+  template <typename T>
+  Ref<T> index(Ref<T> ref, std::size_t idx) {
+    return {ref.offset + idx * sizeof(T)};
+  }
+
+  /// The first object created is at the start of the buffer, it can be used as
+  /// the root of the blob.
+  template <typename T, typename... Ts>
+  Ref<T> create(Ts&&... ts) {
+    Ref<T> res{allocate(sizeof(T), alignof(T))};
+    new (get(res)) T(std::forward<Ts>(ts)...);
+    return res;
+  }
+
+  template <typename T>
+  Ref<T> createArray(std::size_t count) {
+    Ref<T> res{allocate(sizeof(T) * count, alignof(T))};
+    for (std::size_t idx = 0; idx < count; idx++)
+      new (get(res) + idx) T();
+    return res;
+  }
+
+  template <typename IntTy>
+  void setString(Ref<RelString<IntTy>> str, std::string_view value) {
+    Ref<char> chars = createArray<char>(value.size() + 1);
+    std::memcpy(get(chars), value.data(), value.size());
+    get(str)->assign(get(chars), value.size());
+  }
+
+  /// Allocate count default constructed elements for span
+  template <typename T, typename IntTy>
+  Ref<T> setSpan(Ref<RelSpan<T, IntTy>> span, std::size_t count) {
+    Ref<T> elems = createArray<T>(count);
+    get(span)->assign(get(elems), count);
+    return elems;
+  }
+
+  /// Allocate storage for capacity elements for vec
+  template <typename T, typename IntTy>
+  void setVector(Ref<RelVector<T, IntTy>> vec, std::size_t capacity) {
+    Ref<T> storage{allocate(sizeof(T) * capacity, alignof(T))};
+    get(vec)->assign(get(storage), capacity);
+  }
+
+  /// Allocate slots for count elements for map
+  template <typename K, typename V, typename IntTy, typename HashTy>
+  void setHashMap(Ref<RelHashMap<K, V, IntTy, HashTy>> map,
+                  std::size_t count) {
+    using MapTy = RelHashMap<K, V, IntTy, HashTy>;
+    std::size_t capacity = MapTy::getCapacityFor(count);
+    Ref<typename MapTy::Slot> slots =
+        createArray<typename MapTy::Slot>(capacity);
+    get(map)->assign(get(slots), capacity);
+  }
+
+  /// Insert key in map and return the slot of the key, the value is left for
+  /// the caller to set.
+  template <typename K, typename V, typename IntTy, typename HashTy,
+            typename Q>
+  Ref<typename RelHashMap<K, V, IntTy, HashTy>::Slot>
+  insert(Ref<RelHashMap<K, V, IntTy, HashTy>> map, const Q& key) {
+    using SlotTy = typename RelHashMap<K, V, IntTy, HashTy>::Slot;
+    SlotTy& slot = get(map)->insertSlot(key);
+    Ref<SlotTy> res{static_cast<std::size_t>(
+        reinterpret_cast<char*>(&slot) - buffer.data())};
+    if constexpr (IsRelString<K>::value)
+      setString(field(res, &SlotTy::key), key);
+    else
+      get(res)->key = key;
+    return res;
+  }
+
+  const char* data() const { return buffer.data(); }
+  std::size_t size() const { return buffer.size(); }
+};
+
+} // namespace sigta
+
+#endif // SIGTA_COMMON_RELBUILDER_H
@@ -0,0 +1,275 @@
+//===----------------------------------------------------------------------===//
+// Provide bulk operations over arrays of RelPtr.
+//
+// Resolving a RelPtr is an add and a null check. For arrays of self-relative
+// RelPtr<T, int32_t> this is done on several elements at once with SSE2 or
+// AVX2, the null check turning into a mask, and with AVX2 the pointees can be
+// loaded by gather instructions. Other RelPtr are resolved one by one with
+// get().
+//
+// For loops that dereference every element of such an array, prefetchRelPtrs
+// iterates over the pointers while prefetching the pointees a few elements
+// ahead, so the cache misses of consecutive elements overlap.
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_REL_BULK_H
+#define SIGTA_COMMON_REL_BULK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#define SIGTA_REL_BULK_SIMD 1
+#else
+#define SIGTA_REL_BULK_SIMD 0
+#endif
+
+#include "sigta/common/RelContainers.h"
+#include "sigta/common/RelPtr.h"
+
+namespace sigta {
+
+namespace relbulk_detail {
+
+/// Only self-relative 32 bits RelPtr are resolved with SIMD
+template <typename IntTy, typename TraitTy>
+constexpr bool hasVec = SIGTA_REL_BULK_SIMD &&
+                        std::is_same_v<IntTy, int32_t> &&
+                        std::is_same_v<TraitTy, RelPtrTraits<int32_t>>;
+
+#if SIGTA_REL_BULK_SIMD
+#if defined(__AVX2__)
+constexpr std::size_t lanes = 8;
+
+/// Addresses of 8 RelPtr, in 2 halves of 4, with a mask of the non-null ones
+struct Resolved {
+  __m256i addr[2];
+  __m128i valid[2];
+};
+
+inline Resolved resolveVec(const char* ptrs) {
+  __m256i offsets = _mm256_loadu_si256((const __m256i*)ptrs);
+  __m256i valid = _mm256_xor_si256(
+      _mm256_cmpeq_epi32(
+          offsets, _mm256_set1_epi32(std::numeric_limits<int32_t>::max())),
+      _mm256_set1_epi32(-1));
+  __m256i self = _mm256_add_epi64(_mm256_set1_epi64x((int64_t)ptrs),
+                                  _mm256_setr_epi64x(0, 4, 8, 12));
+  Resolved res;
+  for (int half = 0; half < 2; half++) {
+    __m128i off32 = half ? _mm256_extracti128_si256(offsets, 1)
+                         : _mm256_castsi256_si128(offsets);
+    res.valid[half] = half ? _mm256_extracti128_si256(valid, 1)
+                           : _mm256_castsi256_si128(valid);
+    res.addr[half] = _mm256_add_epi64(self, _mm256_cvtepi32_epi64(off32));
+    self = _mm256_add_epi64(self, _mm256_set1_epi64x(16));
+  }
+  return res;
+}
+
+/// Write the addresses of the 8 RelPtr at ptrs to out, 0 for null pointers
+inline void resolve(const char* ptrs, uintptr_t* out) {
+  Resolved res = resolveVec(ptrs);
+  for (int half = 0; half < 2; half++)
+    _mm256_storeu_si256(
+        (__m256i*)(out + half * 4),
+        _mm256_and_si256(_mm256_cvtepi32_epi64(res.valid[half]),
+                         res.addr[half]));
+}
+
+/// Load the Size bytes values pointed to by the 8 RelPtr at ptrs to out with
+/// hardware gathers, null pointers are replaced by fallback
+template <std::size_t Size>
+void gather(const char* ptrs, const void* fallback, void* out) {
+  Resolved res = resolveVec(ptrs);
+  if constexpr (Size == 8) {
+    long long bits;
+    std::memcpy(&bits, fallback, Size);
+    __m256i fb = _mm256_set1_epi64x(bits);
+    for (int half = 0; half < 2; half++)
+      _mm256_storeu_si256(
+          (__m256i*)out + half,
+          _mm256_mask_i64gather_epi64(fb, (const long long*)nullptr,
+                                      res.addr[half],
+                                      _mm256_cvtepi32_epi64(res.valid[half]),
+                                      1));
+  } else {
+    static_assert(Size == 4);
+    int bits;
+    std::memcpy(&bits, fallback, Size);
+    __m128i fb = _mm_set1_epi32(bits);
+    for (int half = 0; half < 2; half++)
+      _mm_storeu_si128((__m128i*)out + half,
+                       _mm256_mask_i64gather_epi32(fb, (const int*)nullptr,
+                                                   res.addr[half],
+                                                   res.valid[half], 1));
+  }
+}
+
+template <typename T>
+constexpr bool hasGather = sizeof(T) == 4 || sizeof(T) == 8;
+#else
+constexpr std::size_t lanes = 4;
+
+/// Write the addresses of the 4 RelPtr at ptrs to out, 0 for null pointers.
+/// SSE2 has no sign extension so offsets are interleaved with their sign.
+inline void resolve(const char* ptrs, uintptr_t* out) {
+  __m128i offsets = _mm_loadu_si128((const __m128i*)ptrs);
+  __m128i isNull = _mm_cmpeq_epi32(
+      offsets, _mm_set1_epi32(std::numeric_limits<int32_t>::max()));
+  __m128i sign = _mm_srai_epi32(offsets, 31);
+  __m128i self = _mm_add_epi64(_mm_set1_epi64x((int64_t)ptrs),
+                               _mm_set_epi64x(4, 0));
+  __m128i off64[2] = {_mm_unpacklo_epi32(offsets, sign),
+                      _mm_unpackhi_epi32(offsets, sign)};
+  __m128i null64[2] = {_mm_unpacklo_epi32(isNull, isNull),
+                       _mm_unpackhi_epi32(isNull, isNull)};
+  for (int half = 0; half < 2; half++) {
+    __m128i addr = _mm_add_epi64(self, off64[half]);
+    addr = _mm_andnot_si128(null64[half], addr);
+    _mm_storeu_si128((__m128i*)(out + half * 2), addr);
+    self = _mm_add_epi64(self, _mm_set1_epi64x(8));
+  }
+}
+#endif
+#endif
+
+} // namespace relbulk_detail
+
+/// Write in out[i] the pointer ptrs[i] points to, nullptr for null pointers
+template <typename T, typename IntTy, typename TraitTy>
+void resolveRelPtrs(const RelPtr<T, IntTy, TraitTy>* ptrs, std::size_t size,
+                    T** out) {
+  std::size_t idx = 0;
+#if SIGTA_REL_BULK_SIMD
+  if constexpr (relbulk_detail::hasVec<IntTy, TraitTy>) {
+    static_assert(sizeof(T*) == sizeof(uintptr_t) &&
+                  sizeof(RelPtr<T, IntTy, TraitTy>) == sizeof(int32_t));
+    constexpr std::size_t lanes = relbulk_detail::lanes;
+    for (; idx + lanes <= size; idx += lanes)
+      relbulk_detail::resolve(reinterpret_cast<const char*>(ptrs + idx),
+                              reinterpret_cast<uintptr_t*>(out + idx));
+  }
+#endif
+  for (; idx < size; idx++)
+    out[idx] = ptrs[idx].get();
+}
+
+/// Write in out[i] a copy of the T ptrs[i] points to, or fallback if ptrs[i]
+/// is null. With AVX2, 4 and 8 bytes values are loaded with gather
+/// instructions.
+template <typename T, typename IntTy, typename TraitTy>
+void gatherRelPtrs(const RelPtr<T, IntTy, TraitTy>* ptrs, std::size_t size,
+                   std::remove_const_t<T>* out,
+                   const std::remove_const_t<T>& fallback = {}) {
+  static_assert(std::is_trivially_copyable_v<std::remove_const_t<T>>,
+                "only trivially copyable values can be gathered");
+  std::size_t idx = 0;
+  // There is no gather instruction before AVX2
+#if defined(__AVX2__)
+  if constexpr (relbulk_detail::hasVec<IntTy, TraitTy> &&
+                relbulk_detail::hasGather<T>) {
+    constexpr std::size_t lanes = relbulk_detail::lanes;
+    for (; idx + lanes <= size; idx += lanes)
+      relbulk_detail::gather<sizeof(T)>(
+          reinterpret_cast<const char*>(ptrs + idx), &fallback, out + idx);
+  }
+#endif
+  for (; idx < size; idx++)
+    out[idx] = ptrs[idx] ? *ptrs[idx] : fallback;
+}
+
+template <typename T, typename IntTy, typename TraitTy, typename SizeIntTy>
+void resolveRelPtrs(const RelSpan<RelPtr<T, IntTy, TraitTy>, SizeIntTy>& ptrs,
+                    T** out) {
+  resolveRelPtrs(ptrs.data(), ptrs.size(), out);
+}
+
+template <typename T, typename IntTy, typename TraitTy, typename SizeIntTy>
+void gatherRelPtrs(const RelSpan<RelPtr<T, IntTy, TraitTy>, SizeIntTy>& ptrs,
+                   std::remove_const_t<T>* out,
+                   const std::remove_const_t<T>& fallback = {}) {
+  gatherRelPtrs(ptrs.data(), ptrs.size(), out, fallback);
+}
+
+/// Range over an array of RelPtr, yielding the pointers they point to. When
+/// an element is reached, the pointee of the element Distance positions ahead
+/// is prefetched.
+template <typename T, typename IntTy, typename TraitTy,
+          std::size_t Distance = 8>
+class RelPrefetchRange {
+  using PtrTy = RelPtr<T, IntTy, TraitTy>;
+  const PtrTy* first;
+  const PtrTy* last;
+
+public:
+  class iterator {
+    const PtrTy* cur;
+    const PtrTy* last;
+
+    void prefetch() const {
+      if (last - cur > (std::ptrdiff_t)Distance)
+        if (T* ahead = cur[Distance].get())
+          __builtin_prefetch(ahead);
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T* const*;
+    using reference = T*;
+
+    iterator(const PtrTy* c, const PtrTy* l) : cur(c), last(l) {}
+
+    T* operator*() const { return cur->get(); }
+    iterator& operator++() {
+      ++cur;
+      prefetch();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator res = *this;
+      ++*this;
+      return res;
+    }
+    bool operator==(const iterator& other) const { return cur == other.cur; }
+    bool operator!=(const iterator& other) const { return cur != other.cur; }
+  };
+
+  RelPrefetchRange(const PtrTy* ptrs, std::size_t size)
+      : first(ptrs), last(ptrs + size) {}
+
+  /// Also prefetch the first Distance pointees
+  iterator begin() const {
+    for (const PtrTy* p = first; p < last && p < first + Distance; p++)
+      if (T* pointee = p->get())
+        __builtin_prefetch(pointee);
+    return iterator(first, last);
+  }
+  iterator end() const { return iterator(last, last); }
+};
+
+template <std::size_t Distance = 8, typename T, typename IntTy,
+          typename TraitTy>
+RelPrefetchRange<T, IntTy, TraitTy, Distance>
+prefetchRelPtrs(const RelPtr<T, IntTy, TraitTy>* ptrs, std::size_t size) {
+  return {ptrs, size};
+}
+
+template <std::size_t Distance = 8, typename T, typename IntTy,
+          typename TraitTy, typename SizeIntTy>
+RelPrefetchRange<T, IntTy, TraitTy, Distance>
+prefetchRelPtrs(const RelSpan<RelPtr<T, IntTy, TraitTy>, SizeIntTy>& ptrs) {
+  return {ptrs.data(), ptrs.size()};
+}
+
+} // namespace sigta
+
+#endif
@@ -0,0 +1,246 @@
+//===----------------------------------------------------------------------===//
+//
+// This file provides containers whose internal references are all RelPtr. Like
+// RelPtr they keep pointing to the same data when memcpy'ed (or mapped from a
+// file) together with it.
+//
+// They do not own their memory. They are meant to be laid out in a single blob
+// by a RelBuilder and used in place, so like RelPtr they can't be copied.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_RELCONTAINERS_H
+#define SIGTA_COMMON_RELCONTAINERS_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "sigta/common/Extras.h"
+#include "sigta/common/RelPtr.h"
+
+namespace sigta {
+
+/// View on a contiguous sequence of T
+template <typename T, typename IntTy = int32_t>
+class RelSpan {
+protected:
+  using SizeTy = std::make_unsigned_t<IntTy>;
+
+  RelPtr<T, IntTy> Data;
+  SizeTy Size = 0;
+
+  static SizeTy checkSize(std::size_t size) {
+    assert(static_cast<SizeTy>(size) == size && "size doesn't fit");
+    return static_cast<SizeTy>(size);
+  }
+
+public:
+  RelSpan() = default;
+  RelSpan(T* data, std::size_t size) : Data(data), Size(checkSize(size)) {}
+
+  void assign(T* data, std::size_t size) {
+    Data = data;
+    Size = checkSize(size);
+  }
+
+  T* data() const { return Data.get(); }
+  std::size_t size() const { return Size; }
+  bool empty() const { return Size == 0; }
+  T* begin() const { return data(); }
+  T* end() const { return data() + Size; }
+  T& operator[](std::size_t idx) const {
+    assert(idx < Size);
+    return data()[idx];
+  }
+};
+
+/// Vector with a fixed capacity. The storage is allocated when the vector is
+/// laid out and elements can then be added in place.
+template <typename T, typename IntTy = int32_t>
+class RelVector : public RelSpan<T, IntTy> {
+  using Base = RelSpan<T, IntTy>;
+  typename Base::SizeTy Capacity = 0;
+
+public:
+  RelVector() = default;
+
+  /// Use storage, which should have room for capacity Ts, as storage
+  void assign(T* storage, std::size_t capacity) {
+    Base::assign(storage, 0);
+    Capacity = Base::checkSize(capacity);
+  }
+
+  std::size_t capacity() const { return Capacity; }
+
+  template <typename... Ts>
+  T& emplace_back(Ts&&... ts) {
+    assert(this->Size < Capacity && "RelVector is full");
+    T* res = new (this->data() + this->Size) T(std::forward<Ts>(ts)...);
+    this->Size++;
+    return *res;
+  }
+  void push_back(const T& value) { emplace_back(value); }
+  void pop_back() {
+    assert(!this->empty() && "RelVector is empty");
+    this->Size--;
+    this->data()[this->Size].~T();
+  }
+};
+
+/// Null terminated string
+template <typename IntTy = int32_t>
+class RelString {
+  /// Doesn't include the null terminator
+  RelSpan<char, IntTy> Chars;
+
+public:
+  RelString() = default;
+
+  /// str should point to size chars followed by a null terminator
+  void assign(char* str, std::size_t size) {
+    assert(str[size] == '\0');
+    Chars.assign(str, size);
+  }
+
+  std::size_t size() const { return Chars.size(); }
+  bool empty() const { return Chars.empty(); }
+  /// May be nullptr for an empty string, unlike c_str
+  const char* data() const { return Chars.data(); }
+  const char* c_str() const { return Chars.data() ? Chars.data() : ""; }
+  std::string_view view() const { return {c_str(), size()}; }
+  operator std::string_view() const { return view(); }
+
+  friend bool operator==(const RelString& l, std::string_view r) {
+    return l.view() == r;
+  }
+  friend bool operator==(std::string_view l, const RelString& r) {
+    return l == r.view();
+  }
+  friend bool operator!=(const RelString& l, std::string_view r) {
+    return !(l == r);
+  }
+  friend bool operator!=(std::string_view l, const RelString& r) {
+    return !(l == r);
+  }
+};
+
+/// Hash used by RelHashMap. It must be stable across processes since the
+/// hashes are stored in the blob.
+template <typename K>
+struct RelHash {
+  static_assert(std::is_integral_v<K> || std::is_enum_v<K>,
+                "RelHash should be specialized for this type");
+  static uint64_t hash(K key) { return extra::hashInt((uint64_t)key); }
+  static bool equal(K l, K r) { return l == r; }
+};
+
+template <typename IntTy>
+struct RelHash<RelString<IntTy>> {
+  static uint64_t hash(std::string_view key) { return extra::hashBytes(key); }
+  static bool equal(const RelString<IntTy>& l, std::string_view r) {
+    return l == r;
+  }
+};
+
+/// Open-addressing hash map with linear probing. Slots are laid out when the
+/// map is built and the map is read-only afterward.
+template <typename K, typename V, typename IntTy = int32_t,
+          typename HashTy = RelHash<K>>
+class RelHashMap {
+public:
+  struct Slot {
+    /// 0 for empty slots, otherwise bits of the hash of the key
+    uint32_t Ctrl;
+    K key;
+    V value;
+  };
+
+private:
+  RelSpan<Slot, IntTy> Slots;
+  std::make_unsigned_t<IntTy> Count = 0;
+
+  static uint32_t getCtrl(uint64_t hash) { return (uint32_t)(hash >> 32) | 1; }
+
+  template <typename Q>
+  Slot* findSlot(const Q& key) const {
+    if (Slots.empty())
+      return nullptr;
+    uint64_t hash = HashTy::hash(key);
+    uint32_t ctrl = getCtrl(hash);
+    std::size_t mask = Slots.size() - 1;
+    for (std::size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+      Slot& slot = Slots[idx];
+      if (slot.Ctrl == 0)
+        return nullptr;
+      if (slot.Ctrl == ctrl && HashTy::equal(slot.key, key))
+        return &slot;
+    }
+  }
+
+public:
+  RelHashMap() = default;
+
+  /// Return the number of slots needed to hold count elements
+  static std::size_t getCapacityFor(std::size_t count) {
+    std::size_t capacity = 1;
+    while (capacity < count * 2)
+      capacity *= 2;
+    return capacity;
+  }
+
+  /// Use slots as storage, slots must be zero initialized and capacity a power
+  /// of 2 returned by getCapacityFor
+  void assign(Slot* slots, std::size_t capacity) {
+    assert((capacity & (capacity - 1)) == 0 && "should be a power of 2");
+    Slots.assign(slots, capacity);
+    Count = 0;
+  }
+
+  /// Reserve a slot for key. The caller is in charge of initializing the key
+  /// and value of the slot. key should not already be in the map.
+  template <typename Q>
+  Slot& insertSlot(const Q& key) {
+    assert(!findSlot(key) && "key already in the map");
+    assert(((std::size_t)Count + 1) * 2 <= Slots.size() &&
+           "RelHashMap is full");
+    uint64_t hash = HashTy::hash(key);
+    std::size_t mask = Slots.size() - 1;
+    std::size_t idx = hash & mask;
+    while (Slots[idx].Ctrl != 0)
+      idx = (idx + 1) & mask;
+    Slots[idx].Ctrl = getCtrl(hash);
+    Count++;
+    return Slots[idx];
+  }
+
+  template <typename Q>
+  V* find(const Q& key) const {
+    Slot* slot = findSlot(key);
+    return slot ? &slot->value : nullptr;
+  }
+  template <typename Q>
+  bool contains(const Q& key) const {
+    return findSlot(key);
+  }
+
+  std::size_t size() const { return Count; }
+  bool empty() const { return Count == 0; }
+  const RelSpan<Slot, IntTy>& getSlots() const { return Slots; }
+
+  /// Call fn(key, value) on every element
+  template <typename FnTy>
+  void forEach(FnTy fn) const {
+    for (Slot& slot : Slots)
+      if (slot.Ctrl != 0)
+        fn(slot.key, slot.value);
+  }
+};
+
+} // namespace sigta
+
+#endif // SIGTA_COMMON_RELCONTAINERS_H
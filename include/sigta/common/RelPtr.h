@@ -11,6 +11,15 @@
 //  - when a RelPtr is memcpy'ed(or equivalent) with the data it pointes too it
 //    will still pointe to the same data.
 //
+// RelBaseTraits make offsets relative to the base of a region instead of this.
+// Such a RelPtr is a trivially copyable compressed pointer, usable as a value.
+//
+// When T is aligned, the low bits of the offset are always zero.
+// RelShiftedTraits drops them to reach further with the same IntTy and
+// TaggedRelPtr stores a small tag in them. Both compute offsets from this
+// rounded down to the alignment of T, so they keep working only if the blob is
+// copied to an address with the same alignment.
+//
 //===----------------------------------------------------------------------===//
 
 #ifndef SIGTA_COMMON_RELPTR_H
@@ -18,8 +27,10 @@
 
 #include <cstdint>
 #include <cassert>
+#include <functional>
 #include <limits>
 #include <type_traits>
+#include <utility>
 
 namespace sigta {
 
@@ -33,9 +44,84 @@ template <typename IntTy> struct RelPtrTraits {
   static IntTy getNull(char *self) { return std::numeric_limits<IntTy>::max(); }
 };
 
+/// Offsets relative to a base set for the current thread by a RelBaseScope.
+/// Tag allows different regions to use different bases at the same time.
+/// Since the offset doesn't depend on the address of the RelPtr, it can be
+/// copied, returned or sorted like a plain pointer. But it must only be used
+/// while the base of its region is set.
+template <typename IntTy, typename Tag = void> struct RelBaseTraits {
+  static constexpr bool copyable = true;
+  static char *&getBase() {
+    thread_local char *base = nullptr;
+    return base;
+  }
+  static std::ptrdiff_t getOffset(char *, char *addr) {
+    assert(getBase() && "no base set for this thread");
+    return addr - getBase();
+  }
+  static char *getAddr(char *, std::ptrdiff_t offset) {
+    assert(getBase() && "no base set for this thread");
+    return getBase() + offset;
+  }
+  static IntTy getNull(char *) { return std::numeric_limits<IntTy>::max(); }
+};
+
+/// Set the base of TraitTy for the current thread until destruction
+template <typename TraitTy> class RelBaseScope {
+  char *prev;
+
+public:
+  explicit RelBaseScope(void *base)
+      : prev(std::exchange(TraitTy::getBase(), (char *)base)) {}
+  ~RelBaseScope() { TraitTy::getBase() = prev; }
+  RelBaseScope(const RelBaseScope &) = delete;
+  RelBaseScope &operator=(const RelBaseScope &) = delete;
+};
+
+namespace relptr_detail {
+constexpr unsigned log2(std::size_t value) {
+  return value <= 1 ? 0 : 1 + log2(value / 2);
+}
+
+inline char *alignDown(char *ptr, std::size_t align) {
+  return (char *)((uintptr_t)ptr & ~(uintptr_t)(align - 1));
+}
+
+template <typename TraitTy, typename = void>
+struct IsCopyable : std::false_type {};
+template <typename TraitTy>
+struct IsCopyable<TraitTy, std::void_t<decltype(TraitTy::copyable)>>
+    : std::bool_constant<TraitTy::copyable> {};
+
+/// Deletes the copies of RelPtr when the offset depends on its address
+template <bool Copyable> struct CopyPolicy {};
+template <> struct CopyPolicy<false> {
+  CopyPolicy() = default;
+  CopyPolicy(const CopyPolicy &) = delete;
+  CopyPolicy &operator=(const CopyPolicy &) = delete;
+};
+} // namespace relptr_detail
+
+/// Offsets are stored divided by 2^Shift, so the range of IntTy is multiplied
+/// by 2^Shift. Pointees must be aligned to 2^Shift.
+template <typename IntTy, unsigned Shift> struct RelShiftedTraits {
+  static constexpr std::size_t align = std::size_t(1) << Shift;
+  static std::ptrdiff_t getOffset(char *self, char *addr) {
+    assert((uintptr_t)addr % align == 0 && "pointee is not aligned");
+    return (addr - relptr_detail::alignDown(self, align)) /
+           (std::ptrdiff_t)align;
+  }
+  static char *getAddr(char *self, std::ptrdiff_t offset) {
+    return relptr_detail::alignDown(self, align) +
+           offset * (std::ptrdiff_t)align;
+  }
+  static IntTy getNull(char *) { return std::numeric_limits<IntTy>::max(); }
+};
+
 template <typename T, typename IntTy = std::ptrdiff_t,
           typename TraitTy = RelPtrTraits<IntTy>>
-class RelPtr {
+class RelPtr
+    : relptr_detail::CopyPolicy<relptr_detail::IsCopyable<TraitTy>::value> {
   static_assert(std::numeric_limits<IntTy>::max() <=
                 std::numeric_limits<std::ptrdiff_t>::max());
   static_assert(std::numeric_limits<IntTy>::min() >=
@@ -88,11 +174,124 @@ public:
     return ptr.get() - off;
   }
 
+  friend bool operator==(const RelPtr &l, const RelPtr &r) {
+    return l.get() == r.get();
+  }
+  friend bool operator!=(const RelPtr &l, const RelPtr &r) {
+    return l.get() != r.get();
+  }
+  friend bool operator<(const RelPtr &l, const RelPtr &r) {
+    return std::less<T *>()(l.get(), r.get());
+  }
+
+  /// Comparing with a T* must not go through the implicit constructor, that
+  /// would make a temporary RelPtr whose offset may not fit in IntTy
+  friend bool operator==(const RelPtr &l, const T *r) { return l.get() == r; }
+  friend bool operator==(const T *l, const RelPtr &r) { return l == r.get(); }
+  friend bool operator!=(const RelPtr &l, const T *r) { return l.get() != r; }
+  friend bool operator!=(const T *l, const RelPtr &r) { return l != r.get(); }
+  friend bool operator<(const RelPtr &l, const T *r) {
+    return std::less<const T *>()(l.get(), r);
+  }
+  friend bool operator<(const T *l, const RelPtr &r) {
+    return std::less<const T *>()(l, r.get());
+  }
+
+  /// Unless TraitTy is copyable, this is an in-memory type it should not be
+  /// copied or move
+  RelPtr(const RelPtr &) = default;
+  RelPtr &operator=(const RelPtr &) = default;
+};
+
+/// RelPtr with an offset in units of alignof(T). T must be complete, self
+/// referencing types should use RelShiftedTraits directly.
+template <typename T, typename IntTy = int32_t>
+using ShiftedRelPtr =
+    RelPtr<T, IntTy, RelShiftedTraits<IntTy, relptr_detail::log2(alignof(T))>>;
+
+/// Relative pointer with a tag of TagBits bits stored in the low bits of the
+/// offset, which are always zero since T is aligned. The tag is kept when the
+/// pointer changes, including when it is null.
+template <typename T, unsigned TagBits, typename IntTy = int32_t>
+class TaggedRelPtr {
+  static constexpr std::size_t align = std::size_t(1) << TagBits;
+  static constexpr IntTy tagMask = (IntTy)(align - 1);
+  static constexpr IntTy nullOffset = std::numeric_limits<IntTy>::max() &
+                                      (IntTy)~tagMask;
+  IntTy Value;
+
+  char *getBase() const {
+    return relptr_detail::alignDown(
+        reinterpret_cast<char *>(const_cast<TaggedRelPtr *>(this)), align);
+  }
+  void set(T *other, unsigned tag) {
+    // Checked here since T may be incomplete when the class is instantiated
+    static_assert(TagBits > 0 && align <= alignof(T),
+                  "T isn't aligned enough to hold the tag");
+    assert(tag <= (unsigned)tagMask && "tag doesn't fit");
+    std::ptrdiff_t off = nullOffset;
+    if (other) {
+      assert((uintptr_t)other % align == 0 && "pointee is not aligned");
+      off = (char *)other - getBase();
+      assert(static_cast<IntTy>(off) == off && off != nullOffset &&
+             "offset doesn't fit");
+    }
+    Value = (IntTy)off | (IntTy)tag;
+  }
+
+public:
+  static constexpr unsigned maxTag = (unsigned)tagMask;
+
+  TaggedRelPtr() : TaggedRelPtr(nullptr) {}
+  TaggedRelPtr(std::nullptr_t, unsigned tag = 0) { set(nullptr, tag); }
+  TaggedRelPtr(T *other, unsigned tag = 0) { set(other, tag); }
+
+  T *get() const {
+    IntTy off = Value & (IntTy)~tagMask;
+    return off == nullOffset ? nullptr : (T *)(getBase() + off);
+  }
+  unsigned getTag() const { return (unsigned)(Value & tagMask); }
+
+  void setTag(unsigned tag) {
+    assert(tag <= (unsigned)tagMask && "tag doesn't fit");
+    Value = (Value & (IntTy)~tagMask) | (IntTy)tag;
+  }
+  /// Keep the current tag
+  TaggedRelPtr &operator=(T *other) {
+    set(other, getTag());
+    return *this;
+  }
+  void setPointerAndTag(T *other, unsigned tag) { set(other, tag); }
+
+  T &operator*() const {
+    assert(get());
+    return *get();
+  }
+  T *operator->() const {
+    assert(get());
+    return get();
+  }
+  explicit operator bool() const { return get(); }
+  bool operator!() const { return !get(); }
+
   /// This is an in-memory type it should not be copied or move
-  RelPtr(const RelPtr &) = delete;
-  RelPtr &operator=(const RelPtr &) = delete;
+  TaggedRelPtr(const TaggedRelPtr &) = delete;
+  TaggedRelPtr &operator=(const TaggedRelPtr &) = delete;
 };
 
+/// Pointer to T stored as a 32-bit offset from the base of a region
+template <typename T, typename Tag = void>
+using CompressedPtr = RelPtr<T, uint32_t, RelBaseTraits<uint32_t, Tag>>;
+
 } // namespace sigta
 
+namespace std {
+template <typename T, typename IntTy, typename TraitTy>
+struct hash<sigta::RelPtr<T, IntTy, TraitTy>> {
+  std::size_t operator()(const sigta::RelPtr<T, IntTy, TraitTy> &ptr) const {
+    return std::hash<T *>()(ptr.get());
+  }
+};
+} // namespace std
+
 #endif // SIGTA_COMMON_RELPTR_H
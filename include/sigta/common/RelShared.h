@@ -0,0 +1,234 @@
+//===----------------------------------------------------------------------===//
+//
+// This file provides RelSharedRegion, a shared memory region holding RelPtr
+// based data, so that several processes can use a single copy of a dataset.
+//
+// The region is mapped at a different address in each process, which is fine
+// since RelPtr and the containers of RelContainers.h only store offsets. One
+// publisher creates the region and builds objects in it with a RelArena, then
+// publishes a root. Readers attach to the region read-only and get the last
+// published root.
+//
+// Publishing a new root is a single atomic store, so readers switch from one
+// generation of the data to the next atomically. Generations are never
+// overwritten: the memory of old generations stays valid for readers until
+// the region is unmapped by every process, at the cost of not being reused.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_RELSHARED_H
+#define SIGTA_COMMON_RELSHARED_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <utility>
+
+#include "sigta/common/RTTI.h"
+#include "sigta/common/RelArena.h"
+
+namespace sigta {
+
+template <typename IntTy = int32_t>
+class RelSharedRegion {
+  static constexpr uint64_t regionMagic = 0x5349475441534852;
+  static constexpr uint64_t noVersion = std::numeric_limits<uint64_t>::max();
+
+  /// Start of the region, the data follows it
+  struct alignas(64) Header {
+    uint64_t magic;
+    uint64_t capacity;
+    /// Offset in the data of the current Version or noVersion
+    std::atomic<uint64_t> current;
+  };
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "readers only have read access to the header");
+
+  /// Written in the data by publish and never modified afterward
+  struct Version {
+    uint64_t generation;
+    uint64_t typeHash;
+    uint64_t root;
+  };
+
+  void* mapping = nullptr;
+  std::size_t mapSize = 0;
+  RelArena<IntTy> arena{nullptr, 0};
+  bool publisher = false;
+
+  Header& getHeader() const { return *static_cast<Header*>(mapping); }
+  char* getData() const {
+    return static_cast<char*>(mapping) + sizeof(Header);
+  }
+
+  std::size_t getDataSize() const { return mapSize - sizeof(Header); }
+
+  /// The header is written by another process, so offsets read from it are
+  /// checked against the mapping before being used
+  const Version* getVersion() const {
+    uint64_t current = getHeader().current.load(std::memory_order_acquire);
+    if (current == noVersion || getDataSize() < sizeof(Version) ||
+        current > getDataSize() - sizeof(Version) ||
+        current % alignof(Version) != 0)
+      return nullptr;
+    return reinterpret_cast<const Version*>(getData() + current);
+  }
+
+  void unmap() {
+    if (mapping)
+      munmap(mapping, mapSize);
+    mapping = nullptr;
+    mapSize = 0;
+    arena = RelArena<IntTy>(nullptr, 0);
+    publisher = false;
+  }
+
+public:
+  static constexpr std::size_t maxCapacity = RelArena<IntTy>::maxCapacity;
+
+  RelSharedRegion() = default;
+  RelSharedRegion(RelSharedRegion&& other)
+      : mapping(std::exchange(other.mapping, nullptr)),
+        mapSize(std::exchange(other.mapSize, 0)),
+        arena(std::move(other.arena)),
+        publisher(std::exchange(other.publisher, false)) {}
+  RelSharedRegion& operator=(RelSharedRegion&& other) {
+    std::swap(mapping, other.mapping);
+    std::swap(mapSize, other.mapSize);
+    std::swap(arena, other.arena);
+    std::swap(publisher, other.publisher);
+    return *this;
+  }
+  RelSharedRegion(const RelSharedRegion&) = delete;
+  RelSharedRegion& operator=(const RelSharedRegion&) = delete;
+  ~RelSharedRegion() { unmap(); }
+
+  /// Create the shared memory object name with room for capacity bytes of
+  /// data and map it as the publisher. Pages are only backed by memory once
+  /// written. Return false if name already exists or on error.
+  bool create(const char* name, std::size_t capacity, mode_t mode = 0600) {
+    assert(capacity <= maxCapacity && "offsets wouldn't fit IntTy");
+    unmap();
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, mode);
+    if (fd < 0)
+      return false;
+    std::size_t size = sizeof(Header) + capacity;
+    void* res = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+      res = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (res == MAP_FAILED) {
+      shm_unlink(name);
+      return false;
+    }
+    mapping = res;
+    mapSize = size;
+    publisher = true;
+    Header* header = new (mapping) Header;
+    header->magic = regionMagic;
+    header->capacity = capacity;
+    header->current.store(noVersion, std::memory_order_release);
+    arena = RelArena<IntTy>(getData(), capacity);
+    return true;
+  }
+
+  /// Map the shared memory object name read-only as a reader. Return false if
+  /// it doesn't exist or wasn't created by a RelSharedRegion with this IntTy.
+  bool attach(const char* name) {
+    unmap();
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    void* res = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Header))
+      res = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (res == MAP_FAILED)
+      return false;
+    mapping = res;
+    mapSize = st.st_size;
+    const Header& header = getHeader();
+    if (header.magic != regionMagic ||
+        header.capacity != mapSize - sizeof(Header) ||
+        header.capacity > maxCapacity) {
+      unmap();
+      return false;
+    }
+    return true;
+  }
+
+  /// Remove the name of a region. Processes that mapped it keep their mapping
+  /// and the memory is released when the last one unmaps it.
+  static bool remove(const char* name) { return shm_unlink(name) == 0; }
+
+  /// Allocator for the data of the region, only usable by the publisher.
+  /// RelPtr and containers between objects of the arena stay valid in every
+  /// process.
+  RelArena<IntTy>& getArena() {
+    assert(publisher && "readers can't allocate");
+    return arena;
+  }
+
+  /// Make root, which must have been allocated in the arena, the current root
+  /// of the region. Everything reachable from it must be fully built since
+  /// readers can use it as soon as this returns. Return the new generation or
+  /// 0 if the arena is full.
+  template <typename T>
+  uint64_t publish(const T* root) {
+    assert(publisher && "readers can't publish");
+    assert(root && arena.contains(root) && "root should be in the arena");
+    const Version* prev = getVersion();
+    Version* version = arena.template create<Version>();
+    if (!version)
+      return 0;
+    version->generation = prev ? prev->generation + 1 : 1;
+    version->typeHash = rtti::typeHash<T>();
+    version->root = reinterpret_cast<const char*>(root) - getData();
+    getHeader().current.store(reinterpret_cast<char*>(version) - getData(),
+                              std::memory_order_release);
+    return version->generation;
+  }
+
+  /// Return the generation of the current root, starting at 1, or 0 if none
+  /// was published yet
+  uint64_t getGeneration() const {
+    assert(mapping && "no region mapped");
+    const Version* version = getVersion();
+    return version ? version->generation : 0;
+  }
+
+  /// Return the current root or nullptr if none was published yet, it isn't
+  /// a T or it doesn't fit in the region. generation is set to the generation
+  /// of the returned root.
+  template <typename T>
+  const T* getRoot(uint64_t* generation = nullptr) const {
+    assert(mapping && "no region mapped");
+    const Version* version = getVersion();
+    if (!version || version->typeHash != rtti::typeHash<T>() ||
+        getDataSize() < sizeof(T) ||
+        version->root > getDataSize() - sizeof(T))
+      return nullptr;
+    if (generation)
+      *generation = version->generation;
+    return reinterpret_cast<const T*>(getData() + version->root);
+  }
+
+  bool isPublisher() const { return publisher; }
+  bool mapped() const { return mapping; }
+  std::size_t getCapacity() const {
+    return mapping ? getDataSize() : 0;
+  }
+};
+
+} // namespace sigta
+
+#endif // SIGTA_COMMON_RELSHARED_H
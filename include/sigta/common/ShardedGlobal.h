@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+// Provide ShardedGlobal, a global with one replica of its value per CPU.
+//
+// When every core writes the same object, like a counter of events, the cache
+// line holding it moves from core to core on every write. ShardedGlobal keeps
+// one replica per CPU, each on its own cache lines, and a thread only touches
+// the replica of the CPU it runs on. Values that need the state of every
+// replica, like the total of a counter, are computed with reduce, and updates
+// are broadcast to every replica with forEach.
+//
+// A thread can be migrated to another CPU at any point, so two threads can
+// access the same replica at the same time: T must support concurrent
+// accesses, which is usually done with relaxed atomics.
+//
+// The lifetime is managed as usual, ShardedGlobalRefCount gives access to the
+// local replica:
+//   ManagedGlobal<ShardedGlobal<std::atomic<uint64_t>>> counter;
+//   struct Worker : ShardedGlobalRefCount<&counter> { ... get()++ ... };
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_SHARDED_GLOBAL_H
+#define SIGTA_COMMON_SHARDED_GLOBAL_H
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "sigta/common/ManagedObjs.h"
+
+namespace sigta {
+
+namespace shard_detail {
+
+/// Index of the CPU running the current thread, or a value derived from the
+/// thread id if it isn't known
+inline unsigned getCurrentCPU() {
+#if defined(__linux__)
+  int cpu = sched_getcpu();
+  if (cpu >= 0)
+    return cpu;
+#endif
+  thread_local unsigned fallback =
+      std::hash<std::thread::id>()(std::this_thread::get_id());
+  return fallback;
+}
+
+inline std::size_t getCPUCount() {
+  unsigned count = std::thread::hardware_concurrency();
+  return count ? count : 1;
+}
+
+} // namespace shard_detail
+
+/// ShardCount replicas of T, or one per CPU if it is 0. With fewer replicas
+/// than CPUs, CPUs are grouped and each group shares a replica.
+/// Every replica is constructed with the same arguments.
+/// The ShardedGlobal itself is aligned so the reference count of a
+/// ManagedGlobal holding it doesn't share its cache line.
+template <typename T, std::size_t ShardCount = 0>
+class alignas(64) ShardedGlobal {
+  struct alignas(64) Shard {
+    T value;
+    template <typename... Ts>
+    Shard(Ts&&... ts) : value(std::forward<Ts>(ts)...) {}
+  };
+
+  std::size_t count;
+  Shard* shards;
+
+public:
+  using value_type = T;
+
+  template <typename... Ts>
+  ShardedGlobal(const Ts&... ts)
+      : count(ShardCount ? ShardCount : shard_detail::getCPUCount()),
+        shards(static_cast<Shard*>(::operator new(
+            count * sizeof(Shard), std::align_val_t(alignof(Shard))))) {
+    for (std::size_t idx = 0; idx < count; idx++)
+      new (&shards[idx]) Shard(ts...);
+  }
+  ShardedGlobal(const ShardedGlobal&) = delete;
+  ShardedGlobal& operator=(const ShardedGlobal&) = delete;
+  ~ShardedGlobal() {
+    for (std::size_t idx = 0; idx < count; idx++)
+      shards[idx].~Shard();
+    ::operator delete(shards, std::align_val_t(alignof(Shard)));
+  }
+
+  std::size_t size() const { return count; }
+
+  /// Replica of the CPU the calling thread runs on
+  T& local() {
+    // Skip looking up the CPU on single core machines
+    if (count == 1)
+      return shards[0].value;
+    return shards[shard_detail::getCurrentCPU() % count].value;
+  }
+  const T& local() const {
+    return const_cast<ShardedGlobal*>(this)->local();
+  }
+
+  T& getShard(std::size_t idx) {
+    assert(idx < count);
+    return shards[idx].value;
+  }
+  const T& getShard(std::size_t idx) const {
+    assert(idx < count);
+    return shards[idx].value;
+  }
+
+  /// Apply fn(T&) to every replica
+  template <typename FnTy>
+  void forEach(FnTy fn) {
+    for (std::size_t idx = 0; idx < count; idx++)
+      fn(shards[idx].value);
+  }
+
+  /// Fold every replica in init with fn(R, const T&), like std::accumulate
+  template <typename R, typename FnTy>
+  R reduce(R init, FnTy fn) const {
+    for (std::size_t idx = 0; idx < count; idx++)
+      init = fn(std::move(init), shards[idx].value);
+    return init;
+  }
+};
+
+/// Same as GlobalRefCount for a ManagedGlobal of ShardedGlobal, but get
+/// returns the replica of the current CPU. The whole ShardedGlobal is
+/// returned by getAll.
+template <auto Global>
+class ShardedGlobalRefCount : public GlobalRefCount<Global> {
+  using Base = GlobalRefCount<Global>;
+  using ShardedTy =
+      std::remove_reference_t<decltype(std::declval<Base&>().get())>;
+  using T = typename ShardedTy::value_type;
+
+public:
+  T& get() { return Base::get().local(); }
+  const T& get() const { return Base::get().local(); }
+  ShardedTy& getAll() { return Base::get(); }
+  const ShardedTy& getAll() const { return Base::get(); }
+};
+
+} // namespace sigta
+
+#endif
@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+// Provide maps from types to values, keyed by the IDs of RTTI.h
+//
+// TypeMap uses a LinearID as a direct index into an array, UniqueTypeMap is
+// an open-addressing hash table keyed by UniqueID for when no category is
+// available. Both are meant for read-mostly use: lookups are lock-free and may
+// run concurrently with insertions, which are serialized by a mutex.
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_TYPE_MAP_H
+#define SIGTA_COMMON_TYPE_MAP_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "sigta/common/ManagedObjs.h"
+#include "sigta/common/RTTI.h"
+
+namespace sigta {
+
+/// Map from types of a LinearID category to V, stored as one slot per ID.
+/// The array is sized on construction to every ID of the category, so
+/// construct it inside main after all IDs are registered.
+/// get and getOrEmplace can be executed concurrently. erase must not race with
+/// accesses to the same key.
+template <typename V, typename Category, typename IDTy = uint16_t>
+class TypeMap {
+public:
+  using ID = rtti::LinearID<Category, IDTy>;
+
+private:
+  struct Slot {
+    std::atomic<bool> present = false;
+    ManagedObj<V> value;
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  std::size_t size;
+  std::mutex mtx;
+
+  Slot& getSlot(ID id) const {
+    assert(id.getInt() < size && "ID registered after the map was created");
+    return slots[id.getInt()];
+  }
+
+public:
+  TypeMap()
+      : slots(new Slot[ID::maxID().getInt()]), size(ID::maxID().getInt()) {}
+  TypeMap(const TypeMap&) = delete;
+  TypeMap& operator=(const TypeMap&) = delete;
+  ~TypeMap() {
+    for (std::size_t idx = 0; idx < size; idx++)
+      if (slots[idx].present.load(std::memory_order_relaxed))
+        slots[idx].value.destruct();
+  }
+
+  /// Return the value associated to id or nullptr
+  V* get(ID id) const {
+    Slot& slot = getSlot(id);
+    return slot.present.load(std::memory_order_acquire) ? &slot.value.get()
+                                                        : nullptr;
+  }
+
+  /// Construct the value associated to id if there is none and return it
+  template <typename... Ts>
+  V& getOrEmplace(ID id, Ts&&... ts) {
+    if (V* res = get(id))
+      return *res;
+    std::lock_guard<std::mutex> g(mtx);
+    Slot& slot = getSlot(id);
+    if (!slot.present.load(std::memory_order_relaxed)) {
+      slot.value.construct(std::forward<Ts>(ts)...);
+      slot.present.store(true, std::memory_order_release);
+    }
+    return slot.value.get();
+  }
+
+  /// Return true if the value was erased
+  bool erase(ID id) {
+    std::lock_guard<std::mutex> g(mtx);
+    Slot& slot = getSlot(id);
+    if (!slot.present.load(std::memory_order_relaxed))
+      return false;
+    slot.present.store(false, std::memory_order_relaxed);
+    slot.value.destruct();
+    return true;
+  }
+
+  template <typename Ty>
+  V* get() const {
+    return get(ID::template get<Ty>());
+  }
+  template <typename Ty, typename... Ts>
+  V& getOrEmplace(Ts&&... ts) {
+    return getOrEmplace(ID::template get<Ty>(), std::forward<Ts>(ts)...);
+  }
+  template <typename Ty>
+  bool erase() {
+    return erase(ID::template get<Ty>());
+  }
+};
+
+/// Map from any type to V, keyed by UniqueID.
+/// Values are allocated individually so references to them stay valid when
+/// the table grows. Tables replaced by a growth are kept until the map is
+/// destroyed, so readers never observe freed memory.
+/// get and getOrEmplace can be executed concurrently.
+template <typename V>
+class UniqueTypeMap {
+public:
+  using ID = rtti::UniqueID;
+
+private:
+  struct Entry {
+    uintptr_t key;
+    V value;
+  };
+
+  struct Table {
+    unsigned bits;
+    std::unique_ptr<std::atomic<Entry*>[]> slots;
+    std::unique_ptr<Table> prev;
+
+    Table(unsigned b, std::unique_ptr<Table> p)
+        : bits(b), slots(new std::atomic<Entry*>[std::size_t(1) << b]),
+          prev(std::move(p)) {
+      for (std::size_t idx = 0; idx < capacity(); idx++)
+        slots[idx].store(nullptr, std::memory_order_relaxed);
+    }
+    std::size_t capacity() const { return std::size_t(1) << bits; }
+    std::size_t mask() const { return capacity() - 1; }
+    /// Fibonacci hashing, the low bits of a pointer are mostly zeros
+    std::size_t hash(uintptr_t key) const {
+      return (std::size_t)(((uint64_t)key * 0x9e3779b97f4a7c15) >>
+                           (64 - bits));
+    }
+  };
+
+  std::atomic<Table*> table;
+  std::unique_ptr<Table> owner;
+  std::vector<std::unique_ptr<Entry>> entries;
+  std::mutex mtx;
+
+  /// Must hold mtx
+  void insert(Table* t, Entry* entry) {
+    std::size_t idx = t->hash(entry->key);
+    while (t->slots[idx].load(std::memory_order_relaxed))
+      idx = (idx + 1) & t->mask();
+    t->slots[idx].store(entry, std::memory_order_release);
+  }
+
+  /// Must hold mtx
+  void grow() {
+    unsigned bits = owner->bits + 1;
+    owner = std::make_unique<Table>(bits, std::move(owner));
+    for (auto& entry : entries)
+      insert(owner.get(), entry.get());
+    table.store(owner.get(), std::memory_order_release);
+  }
+
+public:
+  UniqueTypeMap() : owner(std::make_unique<Table>(4, nullptr)) {
+    table.store(owner.get(), std::memory_order_relaxed);
+  }
+  UniqueTypeMap(const UniqueTypeMap&) = delete;
+  UniqueTypeMap& operator=(const UniqueTypeMap&) = delete;
+
+  /// Return the value associated to id or nullptr
+  V* get(ID id) const {
+    Table* t = table.load(std::memory_order_acquire);
+    uintptr_t key = id.getInt();
+    for (std::size_t idx = t->hash(key);; idx = (idx + 1) & t->mask()) {
+      Entry* entry = t->slots[idx].load(std::memory_order_acquire);
+      if (!entry)
+        return nullptr;
+      if (entry->key == key)
+        return &entry->value;
+    }
+  }
+
+  /// Construct the value associated to id if there is none and return it
+  template <typename... Ts>
+  V& getOrEmplace(ID id, Ts&&... ts) {
+    if (V* res = get(id))
+      return *res;
+    std::lock_guard<std::mutex> g(mtx);
+    if (V* res = get(id))
+      return *res;
+    if ((entries.size() + 1) * 2 > owner->capacity())
+      grow();
+    entries.push_back(std::unique_ptr<Entry>(
+        new Entry{id.getInt(), V(std::forward<Ts>(ts)...)}));
+    insert(owner.get(), entries.back().get());
+    return entries.back()->value;
+  }
+
+  template <typename Ty>
+  V* get() const {
+    return get(ID::get<Ty>());
+  }
+  template <typename Ty, typename... Ts>
+  V& getOrEmplace(Ts&&... ts) {
+    return getOrEmplace(ID::get<Ty>(), std::forward<Ts>(ts)...);
+  }
+};
+
+} // namespace sigta
+
+#endif
@@ -0,0 +1,224 @@
+//===----------------------------------------------------------------------===//
+// Provide VersionedGlobal, a holder for read-mostly state that can be replaced
+// while it is being read.
+//
+// Readers take a Snapshot of the current version, which is wait-free: it only
+// publishes the current epoch for the thread and loads a pointer. Writers
+// publish a new version with an atomic exchange and retire the old one, which
+// is destroyed once every reader that could have seen it left its critical
+// section (epoch-based reclamation). Readers never wait for writers.
+//
+// The lifetime of the VersionedGlobal itself can be managed as usual:
+//   ManagedGlobal<VersionedGlobal<Config>> config;
+//===----------------------------------------------------------------------===//
+
+#ifndef SIGTA_COMMON_VERSIONED_GLOBAL_H
+#define SIGTA_COMMON_VERSIONED_GLOBAL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace sigta {
+
+namespace epoch_detail {
+
+/// State of a thread, reused by other threads after it exits
+struct alignas(64) Record {
+  /// Epoch at which the thread entered its critical section or 0 outside
+  std::atomic<uint64_t> epoch = 0;
+  std::atomic<bool> used = true;
+  Record* next = nullptr;
+  /// Number of nested critical sections, only accessed by its thread
+  uint32_t depth = 0;
+};
+
+/// Shared by every VersionedGlobal, so threads only need one record
+class Domain {
+  struct Retired {
+    void* ptr;
+    void (*deleter)(void*);
+    uint64_t epoch;
+  };
+
+  std::atomic<uint64_t> epoch = 1;
+  std::atomic<Record*> records = nullptr;
+  std::mutex mtx;
+  std::vector<Retired> retired;
+
+  Record* acquireRecord() {
+    for (Record* r = records.load(std::memory_order_acquire); r; r = r->next) {
+      bool used = false;
+      if (!r->used.load(std::memory_order_relaxed) &&
+          r->used.compare_exchange_strong(used, true,
+                                          std::memory_order_acquire))
+        return r;
+    }
+    Record* r = new Record;
+    r->next = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(r->next, r,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed))
+      ;
+    return r;
+  }
+
+  /// Give the record back when the thread exits
+  struct ThreadRecord {
+    Record* record;
+    ThreadRecord() : record(get().acquireRecord()) {}
+    ~ThreadRecord() {
+      assert(record->depth == 0);
+      record->used.store(false, std::memory_order_release);
+    }
+  };
+
+  /// Must hold mtx
+  void reclaimLocked() {
+    uint64_t minEpoch = std::numeric_limits<uint64_t>::max();
+    for (Record* r = records.load(std::memory_order_acquire); r; r = r->next)
+      if (uint64_t e = r->epoch.load(std::memory_order_seq_cst))
+        minEpoch = std::min(minEpoch, e);
+    std::size_t kept = 0;
+    for (Retired& item : retired) {
+      if (item.epoch < minEpoch)
+        item.deleter(item.ptr);
+      else
+        retired[kept++] = item;
+    }
+    retired.resize(kept);
+  }
+
+public:
+  static Domain& get() {
+    static Domain domain;
+    return domain;
+  }
+  ~Domain() {
+    for (Retired& item : retired)
+      item.deleter(item.ptr);
+    for (Record* r = records.load(std::memory_order_relaxed); r;)
+      delete std::exchange(r, r->next);
+  }
+
+  static Record& getRecord() {
+    thread_local ThreadRecord tr;
+    return *tr.record;
+  }
+
+  /// The store of the epoch, the loads of published pointers by readers, the
+  /// exchanges of pointers and the loads of the epochs by writers are all
+  /// seq_cst. So either a writer scanning records sees the epoch, or the
+  /// reader sees what the writer published before scanning.
+  void enter(Record& r) {
+    if (r.depth++ == 0)
+      r.epoch.store(epoch.load(std::memory_order_acquire),
+                    std::memory_order_seq_cst);
+  }
+  void exit(Record& r) {
+    assert(r.depth > 0);
+    if (--r.depth == 0)
+      r.epoch.store(0, std::memory_order_release);
+  }
+
+  /// ptr was just unpublished, destroy it once every reader that may have
+  /// seen it is done
+  template <typename T>
+  void retire(T* ptr) {
+    std::lock_guard<std::mutex> g(mtx);
+    uint64_t e = epoch.fetch_add(1, std::memory_order_acq_rel);
+    retired.push_back({ptr, [](void* p) { delete static_cast<T*>(p); }, e});
+    reclaimLocked();
+  }
+
+  void reclaim() {
+    std::lock_guard<std::mutex> g(mtx);
+    reclaimLocked();
+  }
+};
+
+} // namespace epoch_detail
+
+/// Read-mostly T that can be replaced atomically. get the current version
+/// with read and replace it with emplace, publish or update.
+template <typename T>
+class VersionedGlobal {
+  std::atomic<T*> current;
+  /// Serializes writers, readers never take it
+  std::mutex writeMtx;
+
+  /// Must hold writeMtx
+  void swap(T* next) {
+    T* prev = current.exchange(next, std::memory_order_seq_cst);
+    epoch_detail::Domain::get().retire(prev);
+  }
+
+public:
+  /// Pointer to a version of the T, which stays alive while the snapshot
+  /// does. A snapshot must be destroyed by the thread that created it.
+  class Snapshot {
+    epoch_detail::Record& record;
+    const T* ptr;
+
+    friend class VersionedGlobal;
+    Snapshot(const std::atomic<T*>& current)
+        : record(epoch_detail::Domain::getRecord()) {
+      epoch_detail::Domain::get().enter(record);
+      ptr = current.load(std::memory_order_seq_cst);
+    }
+
+  public:
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+    ~Snapshot() { epoch_detail::Domain::get().exit(record); }
+
+    const T& get() const { return *ptr; }
+    const T& operator*() const { return *ptr; }
+    const T* operator->() const { return ptr; }
+  };
+
+  template <typename... Ts>
+  VersionedGlobal(Ts&&... ts) : current(new T(std::forward<Ts>(ts)...)) {}
+  VersionedGlobal(const VersionedGlobal&) = delete;
+  VersionedGlobal& operator=(const VersionedGlobal&) = delete;
+  /// No snapshot should be alive
+  ~VersionedGlobal() { delete current.load(std::memory_order_relaxed); }
+
+  Snapshot read() const { return Snapshot(current); }
+
+  /// Make next the current version
+  void publish(std::unique_ptr<T> next) {
+    assert(next);
+    std::lock_guard<std::mutex> g(writeMtx);
+    swap(next.release());
+  }
+
+  template <typename... Ts>
+  void emplace(Ts&&... ts) {
+    publish(std::make_unique<T>(std::forward<Ts>(ts)...));
+  }
+
+  /// Publish a copy of the current version modified by fn(T&). Concurrent
+  /// updates are serialized so none of them is lost.
+  template <typename FnTy>
+  void update(FnTy fn) {
+    std::lock_guard<std::mutex> g(writeMtx);
+    auto next = std::make_unique<T>(*current.load(std::memory_order_relaxed));
+    fn(*next);
+    swap(next.release());
+  }
+
+  /// Destroy the retired versions that no reader can see anymore. This is
+  /// also done on every publication.
+  static void reclaim() { epoch_detail::Domain::get().reclaim(); }
+};
+
+} // namespace sigta
+
+#endif
@@ -104,6 +104,21 @@ TEST(ECS, layout) {
   EXPECT_EQ(ent2->ecs_get<TestComponent12>(), base2->ecs_get<TestComponent12>());
 }
 
+struct EmptyTag {};
+struct FinalTag final {};
+
+TEST(ECS, emptyComponents) {
+  using Storage = ecs_detail::ComponentStorage<std::index_sequence<0, 1>,
+                                               EmptyTag, TestComponent1>;
+  static_assert(sizeof(Storage) == sizeof(TestComponent1));
+  using FinalStorage =
+      ecs_detail::ComponentStorage<std::index_sequence<0>, FinalTag>;
+  static_assert(sizeof(FinalStorage) == 1);
+  Storage storage;
+  EXPECT_EQ(storage.get<TestComponent1>().i, 0);
+  EXPECT_NE((void *)&storage.get<EmptyTag>(), nullptr);
+}
+
 TEST(ECS, complexTypes) {
   static_assert(std::is_trivially_destructible<TestEntity1>::value, "");
   static_assert(std::is_trivially_destructible<TestEntity2>::value, "");
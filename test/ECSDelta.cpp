@@ -0,0 +1,123 @@
+#include "sigta/common/ECSDelta.h"
+#include "sigta/common/ECS.h"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+struct DeltaTopLevelEntity;
+
+using ecs = sigta::ecs_impl<DeltaTopLevelEntity>;
+
+struct DeltaTopLevelEntity : ecs::EntityBase {};
+
+struct Position {
+  float x, y;
+};
+struct Health {
+  int hp;
+};
+struct Local {
+  int value;
+};
+
+struct Unit final
+    : DeltaTopLevelEntity,
+      ecs::EntitySpec<Unit, DeltaTopLevelEntity, Position, Health, Local> {
+  SIGTA_ECS_USING_ENTITY_SPEC;
+};
+
+struct Prop final
+    : DeltaTopLevelEntity,
+      ecs::EntitySpec<Prop, DeltaTopLevelEntity, Position> {
+  SIGTA_ECS_USING_ENTITY_SPEC;
+};
+
+using World = ReplicatedWorld<ecs, Position, Health>;
+
+struct Side {
+  std::vector<std::unique_ptr<Unit>> units;
+  std::vector<std::unique_ptr<Prop>> props;
+  World world;
+  Side(std::size_t count, std::size_t propEvery = 3) {
+    for (std::size_t idx = 0; idx < count; idx++) {
+      if (idx % propEvery == 0)
+        world.add(props.emplace_back(std::make_unique<Prop>()).get());
+      else
+        world.add(units.emplace_back(std::make_unique<Unit>()).get());
+    }
+  }
+};
+
+TEST(ECSDelta, replicate) {
+  ecs::init();
+  constexpr std::size_t count = 200;
+  Side src(count);
+  Side dst(count);
+
+  for (std::size_t idx = 0; idx < count; idx++)
+    src.world.write<Position>(idx)->x = (float)idx;
+  std::vector<char> delta;
+  World::VersionTy acked = src.world.encode(0, delta);
+  EXPECT_TRUE(dst.world.apply(delta.data(), delta.size()));
+  for (std::size_t idx = 0; idx < count; idx++)
+    EXPECT_EQ(dst.world.read<Position>(idx)->x, (float)idx);
+
+  std::vector<char> empty;
+  src.world.encode(acked, empty);
+  EXPECT_EQ(empty.size(), sizeof(ecsdelta_detail::Header));
+
+  src.world.write<Health>(5)->hp = 42;
+  src.world.write<Position>(130)->y = 3;
+  src.world[7]->ecs_get<Local>()->value = 9;
+  delta.clear();
+  acked = src.world.encode(acked, delta);
+  EXPECT_EQ(delta.size(), sizeof(ecsdelta_detail::Header) +
+                              2 * sizeof(ecsdelta_detail::Record) +
+                              sizeof(Health) + sizeof(Position));
+  EXPECT_TRUE(dst.world.apply(delta.data(), delta.size()));
+  EXPECT_EQ(dst.world.read<Health>(5)->hp, 42);
+  EXPECT_EQ(dst.world.read<Position>(130)->y, 3);
+  EXPECT_EQ(dst.world[7]->ecs_get<Local>()->value, 0);
+  EXPECT_EQ(dst.world.getAppliedVersion(), acked);
+}
+
+TEST(ECSDelta, rejectsBadDeltas) {
+  ecs::init();
+  Side src(10);
+  Side dst(10);
+  Side other(11);
+
+  std::vector<char> first;
+  World::VersionTy acked = src.world.encode(0, first);
+  src.world.write<Health>(1)->hp = 7;
+  std::vector<char> second;
+  src.world.encode(acked, second);
+
+  // Depends on the first delta
+  EXPECT_FALSE(dst.world.apply(second.data(), second.size()));
+  EXPECT_FALSE(dst.world.apply(first.data(), first.size() - 1));
+  EXPECT_TRUE(dst.world.apply(first.data(), first.size()));
+  EXPECT_TRUE(dst.world.apply(second.data(), second.size()));
+  EXPECT_EQ(dst.world.read<Health>(1)->hp, 7);
+
+  // Replaying an older delta must not roll the replica back
+  World::VersionTy applied = dst.world.getAppliedVersion();
+  EXPECT_FALSE(dst.world.apply(first.data(), first.size()));
+  EXPECT_FALSE(dst.world.apply(second.data(), second.size()));
+  EXPECT_EQ(dst.world.read<Health>(1)->hp, 7);
+  EXPECT_EQ(dst.world.getAppliedVersion(), applied);
+
+  // Every entity of swapped is a Prop, which has no Health
+  Side swapped(10, 1);
+  std::vector<char> third;
+  src.world.encode(0, third);
+  EXPECT_FALSE(swapped.world.apply(third.data(), third.size()));
+  EXPECT_TRUE(other.world.apply(third.data(), third.size()));
+}
+
+} // namespace
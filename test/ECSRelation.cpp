@@ -0,0 +1,166 @@
+#include "sigta/common/ECSRelation.h"
+#include "sigta/common/ECS.h"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+struct RelTopLevelEntity;
+
+using ecs = sigta::ecs_impl<RelTopLevelEntity>;
+
+struct RelTopLevelEntity : ecs::EntityBase {};
+
+using Tree = Hierarchy<RelTopLevelEntity>;
+using Links = Targets<RelTopLevelEntity, 3>;
+
+struct Position {
+  int x = 0;
+};
+
+struct Node final
+    : RelTopLevelEntity,
+      ecs::EntitySpec<Node, RelTopLevelEntity, Tree, Links, Position> {
+  SIGTA_ECS_USING_ENTITY_SPEC;
+};
+
+struct Leaf final : RelTopLevelEntity,
+                    ecs::EntitySpec<Leaf, RelTopLevelEntity, Tree> {
+  SIGTA_ECS_USING_ENTITY_SPEC;
+};
+
+TEST(ECSRelation, hierarchy) {
+  ecs::init();
+  RelArena<std::ptrdiff_t> arena(1 << 20);
+  auto root = std::make_unique<Node>();
+  auto a = std::make_unique<Node>();
+  auto b = std::make_unique<Leaf>();
+  auto c = std::make_unique<Node>();
+  auto d = std::make_unique<Node>();
+
+  Tree::attach(arena, root.get(), a.get());
+  Tree::attach(arena, root.get(), b.get());
+  Tree::attach(arena, a.get(), c.get());
+  Tree::attach(arena, root.get(), d.get());
+  EXPECT_EQ(Tree::of(c.get()).getParent(), a.get());
+  EXPECT_EQ(Tree::of(root.get()).getParent(), nullptr);
+
+  std::vector<RelTopLevelEntity*> children;
+  Tree::of(root.get()).forEachChild(
+      [&](RelTopLevelEntity& child) { children.push_back(&child); });
+  EXPECT_EQ(children, (std::vector<RelTopLevelEntity*>{a.get(), b.get(),
+                                                       d.get()}));
+
+  a->ecs_get<Position>()->x = 1;
+  d->ecs_get<Position>()->x = 4;
+  int sum = 0;
+  Tree::of(root.get()).forEachChildWith<Position>(
+      [&](RelTopLevelEntity&, Position& pos) { sum += pos.x; });
+  EXPECT_EQ(sum, 5);
+
+  std::vector<std::pair<RelTopLevelEntity*, RelTopLevelEntity*>> edges;
+  Tree::of(root.get()).forEachDescendant(
+      [&](RelTopLevelEntity& parent, RelTopLevelEntity& child) {
+        edges.emplace_back(&parent, &child);
+      });
+  decltype(edges) expected = {{root.get(), a.get()},
+                              {a.get(), c.get()},
+                              {root.get(), b.get()},
+                              {root.get(), d.get()}};
+  EXPECT_EQ(edges, expected);
+
+  Tree::attach(arena, d.get(), a.get());
+  EXPECT_EQ(Tree::of(a.get()).getParent(), d.get());
+  children.clear();
+  Tree::of(root.get()).forEachChild(
+      [&](RelTopLevelEntity& child) { children.push_back(&child); });
+  // The last child took the place of a
+  EXPECT_EQ(children, (std::vector<RelTopLevelEntity*>{d.get(), b.get()}));
+
+  d.reset();
+  EXPECT_EQ(Tree::of(a.get()).getParent(), nullptr);
+  EXPECT_EQ(Tree::of(c.get()).getParent(), a.get());
+  children.clear();
+  Tree::of(root.get()).forEachChild(
+      [&](RelTopLevelEntity& child) { children.push_back(&child); });
+  EXPECT_EQ(children, (std::vector<RelTopLevelEntity*>{b.get()}));
+}
+
+TEST(ECSRelation, contiguousChildren) {
+  ecs::init();
+  RelArena<std::ptrdiff_t> arena(1 << 20);
+  auto root = std::make_unique<Node>();
+  std::vector<std::unique_ptr<Leaf>> leaves;
+  for (int idx = 0; idx < 10; idx++) {
+    leaves.push_back(std::make_unique<Leaf>());
+    EXPECT_TRUE(Tree::attach(arena, root.get(), leaves.back().get()));
+  }
+
+  const Tree::ChildrenTy& links = Tree::of(root.get()).getChildren();
+  ASSERT_EQ(links.size(), 10u);
+  EXPECT_TRUE(arena.contains(links.data()));
+  EXPECT_TRUE(arena.contains(links.data() + 9));
+  for (std::size_t idx = 0; idx < 10; idx++)
+    EXPECT_EQ(links[idx].get(), leaves[idx].get());
+
+  Tree::of(leaves[2].get()).detach();
+  ASSERT_EQ(links.size(), 9u);
+  EXPECT_EQ(links[2].get(), leaves[9].get());
+  leaves[9].reset();
+  EXPECT_EQ(links.size(), 8u);
+  for (std::size_t idx = 0; idx < 8; idx++)
+    EXPECT_EQ(Tree::of(links[idx].get()).getParent(), root.get());
+
+  // attach fails without changing the tree when the children can't grow
+  alignas(Tree::Link) char mem[4 * sizeof(Tree::Link)];
+  RelArena<std::ptrdiff_t> small(mem, sizeof(mem));
+  auto other = std::make_unique<Node>();
+  for (int idx = 0; idx < 4; idx++)
+    EXPECT_TRUE(Tree::attach(small, other.get(), leaves[idx].get()));
+  EXPECT_FALSE(Tree::attach(small, other.get(), leaves[4].get()));
+  EXPECT_EQ(Tree::of(leaves[4].get()).getParent(), root.get());
+  EXPECT_EQ(Tree::of(other.get()).getChildren().size(), 4u);
+  EXPECT_EQ(links.size(), 5u);
+  other.reset();
+  EXPECT_EQ(Tree::of(leaves[0].get()).getParent(), nullptr);
+}
+
+TEST(ECSRelation, targets) {
+  ecs::init();
+  auto src = std::make_unique<Node>();
+  auto t1 = std::make_unique<Node>();
+  auto t2 = std::make_unique<Leaf>();
+  auto t3 = std::make_unique<Node>();
+  auto t4 = std::make_unique<Node>();
+  Links& links = Links::of(src.get());
+
+  EXPECT_TRUE(links.empty());
+  EXPECT_TRUE(links.add(t1.get()));
+  EXPECT_FALSE(links.add(t1.get()));
+  EXPECT_TRUE(links.add(t2.get()));
+  EXPECT_TRUE(links.add(t3.get()));
+  EXPECT_FALSE(links.add(t4.get()));
+  EXPECT_EQ(links.size(), 3u);
+
+  t3->ecs_get<Position>()->x = 3;
+  int count = 0;
+  links.forEachWith<Position>([&](RelTopLevelEntity&, Position& pos) {
+    count++;
+    EXPECT_EQ(pos.x, pos.x == 3 ? 3 : 0);
+  });
+  EXPECT_EQ(count, 2);
+
+  EXPECT_TRUE(links.remove(t1.get()));
+  EXPECT_FALSE(links.remove(t1.get()));
+  EXPECT_EQ(links[0], t2.get());
+  EXPECT_EQ(links[1], t3.get());
+  EXPECT_TRUE(links.add(t4.get()));
+  EXPECT_TRUE(links.contains(t4.get()));
+}
+
+} // namespace
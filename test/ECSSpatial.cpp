@@ -0,0 +1,153 @@
+#include "sigta/common/ECSSpatial.h"
+#include "sigta/common/ECS.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+struct SpatialTopLevelEntity;
+
+using ecs = sigta::ecs_impl<SpatialTopLevelEntity>;
+
+struct SpatialTopLevelEntity : ecs::EntityBase {};
+
+struct Position {
+  float x, y;
+};
+struct Health {
+  int hp;
+};
+
+using Grid = SpatialGrid<ecs, Position>;
+
+struct Unit final : SpatialTopLevelEntity,
+                    ecs::EntitySpec<Unit, SpatialTopLevelEntity, Position,
+                                    Health, Grid::Node> {
+  SIGTA_ECS_USING_ENTITY_SPEC;
+};
+
+struct Marker final : SpatialTopLevelEntity,
+                      ecs::EntitySpec<Marker, SpatialTopLevelEntity, Position,
+                                      Grid::Node> {
+  SIGTA_ECS_USING_ENTITY_SPEC;
+};
+
+TEST(ECSSpatial, matchesScan) {
+  ecs::init();
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> coord(-100, 100);
+  std::vector<std::unique_ptr<Unit>> units;
+  std::vector<std::unique_ptr<Marker>> markers;
+  std::vector<SpatialTopLevelEntity*> all;
+  Grid grid(8);
+  for (int idx = 0; idx < 500; idx++) {
+    SpatialTopLevelEntity* ent;
+    if (idx % 4 == 0)
+      ent = markers.emplace_back(std::make_unique<Marker>()).get();
+    else
+      ent = units.emplace_back(std::make_unique<Unit>()).get();
+    *ent->ecs_get<Position>() = {coord(rng), coord(rng)};
+    grid.insert(ent);
+    all.push_back(ent);
+  }
+  EXPECT_EQ(grid.size(), all.size());
+
+  auto check = [&] {
+    for (int query = 0; query < 20; query++) {
+      float x = coord(rng), y = coord(rng), r = query * 3.f;
+      std::vector<SpatialTopLevelEntity*> expected, found;
+      for (SpatialTopLevelEntity* ent : all) {
+        Position& pos = *ent->ecs_get<Position>();
+        float dx = pos.x - x, dy = pos.y - y;
+        if (ent->ecs_has<Health>() && dx * dx + dy * dy <= r * r)
+          expected.push_back(ent);
+      }
+      grid.view<Health>().withinRadius(
+          x, y, r, [&](SpatialTopLevelEntity& ent, Health&) {
+            found.push_back(&ent);
+          });
+      std::sort(expected.begin(), expected.end());
+      std::sort(found.begin(), found.end());
+      EXPECT_EQ(found, expected);
+    }
+  };
+  check();
+
+  for (SpatialTopLevelEntity* ent : all) {
+    Position& pos = *ent->ecs_get<Position>();
+    pos.x += coord(rng) / 20;
+    pos.y += coord(rng) / 20;
+    grid.update(ent);
+  }
+  check();
+
+  for (std::size_t idx = 0; idx < all.size(); idx += 2)
+    grid.remove(all[idx]);
+  all.erase(std::remove_if(all.begin(), all.end(),
+                           [](SpatialTopLevelEntity* ent) {
+                             return !ent->ecs_get<Grid::Node>()->isIndexed();
+                           }),
+            all.end());
+  EXPECT_EQ(grid.size(), all.size());
+  check();
+}
+
+TEST(ECSSpatial, box) {
+  ecs::init();
+  Grid grid(1);
+  Marker a, b, c;
+  *a.ecs_get<Position>() = {0.5f, 0.5f};
+  *b.ecs_get<Position>() = {-3, 2};
+  *c.ecs_get<Position>() = {2, 2};
+  grid.insert(&a);
+  grid.insert(&b);
+  grid.insert(&c);
+  int count = 0;
+  grid.view<Position>().within(
+      {-3, 0, 2, 2}, [&](SpatialTopLevelEntity&, Position&) { count++; });
+  EXPECT_EQ(count, 3);
+  count = 0;
+  grid.view<>().within({0, 0, 1, 1},
+                       [&](SpatialTopLevelEntity& ent) {
+                         EXPECT_EQ(&ent, &a);
+                         count++;
+                       });
+  EXPECT_EQ(count, 1);
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  constexpr float max = std::numeric_limits<float>::max();
+  for (SpatialBox box : {SpatialBox{-max, -max, max, max},
+                         SpatialBox{-inf, -inf, inf, inf},
+                         SpatialBox{max, max, max, max}}) {
+    count = 0;
+    grid.view<>().within(box, [&](SpatialTopLevelEntity&) { count++; });
+    EXPECT_EQ(count, box.minX == max ? 0 : 3);
+  }
+  EXPECT_EQ(grid.countCells(), 3u);
+  grid.remove(&b);
+  EXPECT_EQ(grid.countCells(), 2u);
+  grid.remove(&a);
+  grid.remove(&c);
+}
+
+#ifndef NDEBUG
+void destroyWhileIndexed() {
+  Grid grid(1);
+  Marker marker;
+  *marker.ecs_get<Position>() = {0, 0};
+  grid.insert(&marker);
+}
+
+TEST(ECSSpatial, destroyedWhileIndexed) {
+  ecs::init();
+  EXPECT_DEATH(destroyWhileIndexed(), "still in a SpatialGrid");
+}
+#endif
+
+} // namespace
@@ -0,0 +1,89 @@
+#include "sigta/common/GlobalInit.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace sigta;
+
+namespace {
+
+std::atomic<int> order = 0;
+
+/// Slow to construct, records when its construction finished
+template <int N>
+struct Table {
+  static inline std::atomic<int> constructCount = 0;
+  static inline int finished = -1;
+  int value = N;
+  Table() {
+    constructCount++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    finished = order++;
+  }
+};
+
+ManagedGlobal<Table<0>> table0;
+ManagedGlobal<Table<1>> table1;
+ManagedGlobal<Table<2>> table2;
+ManagedGlobal<Table<3>> table3;
+
+/// Uses the tables it depends on while being constructed
+struct Router : GlobalRefCount<&table0>, GlobalRefCount<&table2> {
+  static inline int finished = -1;
+  int sum;
+  Router()
+      : sum(GlobalRefCount<&table0>::get().value +
+            GlobalRefCount<&table2>::get().value) {
+    finished = order++;
+  }
+};
+ManagedGlobal<Router> router;
+
+TEST(GlobalInit, Dependencies) {
+  {
+    GlobalInitializer init;
+    init.add(&table0);
+    init.add(&table1);
+    init.add(&table2);
+    init.add(&router, &table0, &table2);
+    EXPECT_FALSE(GlobalRefCount<&router>::is_ready());
+    init.start(2);
+    init.wait();
+    EXPECT_TRUE(init.done());
+    EXPECT_TRUE(GlobalRefCount<&router>::is_ready());
+    EXPECT_GT(Router::finished, Table<0>::finished);
+    EXPECT_GT(Router::finished, Table<2>::finished);
+
+    GlobalRefCount<&router> ref;
+    EXPECT_EQ(2, ref.get().sum);
+    EXPECT_EQ(1, Table<0>::constructCount);
+    EXPECT_EQ(1, Table<2>::constructCount);
+  }
+  // The initializer released its references
+  EXPECT_FALSE(GlobalRefCount<&router>::is_ready());
+  EXPECT_FALSE(GlobalRefCount<&table1>::is_ready());
+}
+
+TEST(GlobalInit, EarlyUse) {
+  GlobalInitializer init;
+  init.add(&table3);
+  init.start(1);
+  // Either waits for the background construction or does it
+  GlobalRefCount<&table3> ref;
+  EXPECT_EQ(3, ref.get().value);
+  init.wait();
+  EXPECT_EQ(1, Table<3>::constructCount);
+}
+
+TEST(GlobalInit, MissingDependency) {
+  EXPECT_DEATH(
+      {
+        GlobalInitializer init;
+        init.add(&router, &table0);
+      },
+      "dependencies should be added");
+}
+
+} // namespace
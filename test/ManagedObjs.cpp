@@ -68,4 +68,99 @@ TEST(ManagedObjs, Threads) {
   EXPECT_EQ(ComplexObj::constructCount, ComplexObj::destructCount);
 }
 
+ManagedGlobal<ComplexObj> biased;
+struct C : BiasedGlobalRefCount<&biased> {};
+
+TEST(ManagedObjs, Biased) {
+  ComplexObj::reset();
+  {
+    C a;
+    C b;
+    EXPECT_EQ(1, ComplexObj::constructCount);
+  }
+  // The thread keeps its reference until flush
+  EXPECT_EQ(0, ComplexObj::destructCount);
+  {
+    C a;
+    EXPECT_EQ(1, ComplexObj::constructCount);
+    C::flush();
+    EXPECT_EQ(0, ComplexObj::destructCount);
+  }
+  C::flush();
+  EXPECT_EQ(1, ComplexObj::destructCount);
+
+  // Threads release their reference when exiting
+  {
+    C a;
+    std::thread t([] {
+      C b;
+      EXPECT_EQ(2, ComplexObj::constructCount);
+    });
+    t.join();
+  }
+  C::flush();
+  EXPECT_EQ(2, ComplexObj::constructCount);
+  EXPECT_EQ(2, ComplexObj::destructCount);
+
+  std::array<std::thread, thread_count> others;
+  for (auto &t : others)
+    t = std::thread([] {
+      for (int i = 0; i < 1000; i++) {
+        {
+          C a;
+          C b;
+        }
+        // The local count is zero, so this releases the global while other
+        // threads may be registering again
+        if (i % 100 == 0)
+          C::flush();
+      }
+    });
+  for (auto &t : others)
+    t.join();
+  EXPECT_EQ(ComplexObj::constructCount, ComplexObj::destructCount);
+}
+
+/// The state isn't atomic, so a holder not ordered after the constructor or
+/// before the destructor is reported by TSan
+struct Checked {
+  static inline std::atomic<int> live = 0;
+  int value;
+  Checked() : value(42) { EXPECT_EQ(1, ++live); }
+  ~Checked() {
+    EXPECT_EQ(42, value);
+    value = 0;
+    live--;
+  }
+};
+
+ManagedGlobal<Checked> checked;
+struct B : GlobalRefCount<&checked> {
+  B() { EXPECT_EQ(42, get().value); }
+  ~B() { EXPECT_EQ(42, get().value); }
+};
+
+TEST(ManagedObjs, Stress) {
+  std::atomic<bool> start = false;
+
+  // Every holder is short-lived so the count keeps going through 0
+  auto run = [&](unsigned seed) {
+    while (!start);
+    for (unsigned i = 0; i < 20000; i++) {
+      B b;
+      if ((i + seed) % 3 == 0) {
+        B nested;
+      }
+    }
+  };
+
+  std::array<std::thread, thread_count> others;
+  for (unsigned i = 0; i < thread_count; i++)
+    others[i] = std::thread(run, i);
+  start = true;
+  for (auto &t : others)
+    t.join();
+  EXPECT_EQ(0, Checked::live);
+}
+
 }
@@ -0,0 +1,72 @@
+#include "sigta/common/Meta.h"
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+using namespace sigta;
+
+namespace {
+
+static_assert(std::is_same_v<meta::at_t<0, char, int, char>, char>);
+static_assert(std::is_same_v<meta::at_t<1, char, int, char>, int>);
+static_assert(std::is_same_v<meta::at_t<2, char, int, char>, char>);
+
+static_assert(meta::find_v<int, char, int, int> == 1);
+static_assert(meta::find_v<long, char, int> == 2);
+static_assert(meta::find_v<long> == 0);
+static_assert(meta::contains_v<int, char, int>);
+static_assert(!meta::contains_v<int>);
+
+static_assert(meta::is_unique_v<>);
+static_assert(meta::is_unique_v<char, int, long>);
+static_assert(!meta::is_unique_v<char, int, char>);
+
+static_assert(std::is_same_v<meta::filter_t<std::is_integral, char, float,
+                                            int, double>,
+                             meta::type_list<char, int>>);
+static_assert(
+    std::is_same_v<meta::filter_t<std::is_integral>, meta::type_list<>>);
+static_assert(std::is_same_v<
+              meta::apply_t<std::tuple, meta::concat_t<meta::type_list<char>,
+                                                       meta::type_list<>,
+                                                       meta::type_list<int>>>,
+              std::tuple<char, int>>);
+
+static_assert(
+    std::is_same_v<meta::sort_by_alignment_t<char, std::uint32_t, std::uint8_t,
+                                             std::uint64_t, std::int32_t>,
+                   meta::type_list<std::uint64_t, std::uint32_t, std::int32_t,
+                                   char, std::uint8_t>>);
+
+static_assert(meta::for_all<std::is_integral, char, int>::value);
+static_assert(!meta::for_all<std::is_integral, char, float>::value);
+static_assert(meta::for_all<std::is_integral>::value);
+static_assert(meta::for_any<std::is_integral, float, int>::value);
+static_assert(!meta::for_any<std::is_integral>::value);
+static_assert(meta::for_none<std::is_integral, float, double>::value);
+static_assert(meta::assert_for_all<std::is_integral, char, int>::value);
+
+struct S1 {
+  char c;
+  int i;
+  short s;
+};
+
+TEST(Meta, Layout) {
+  using L = meta::Layout<char, int, short>;
+  static_assert(L::getSize() == offsetof(S1, s) + sizeof(short));
+  static_assert(L::getAlign() == alignof(int));
+  static_assert(L::getOffset<char>() == offsetof(S1, c));
+  static_assert(L::getOffset<int>() == offsetof(S1, i));
+  static_assert(L::getOffset<short>() == offsetof(S1, s));
+  static_assert(L::has<short>());
+  static_assert(!L::has<long>());
+  static_assert(L::getOffset<int>(5) == 8);
+  static_assert(meta::Layout<>::getSize() == 1);
+  static_assert(meta::Layout<>::getAlign() == 1);
+  EXPECT_EQ(L::getOffset<short>(), offsetof(S1, s));
+}
+
+} // namespace
@@ -0,0 +1,82 @@
+#include "sigta/common/ObjectPool.h"
+#include "gtest/gtest.h"
+#include "TestCommon.h"
+
+#include <array>
+#include <thread>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+struct Message {
+  int id;
+  std::vector<int> payload;
+  Message(int i) : id(i), payload(4, i) {}
+};
+
+TEST(ObjectPool, Basic) {
+  ObjectPool<Message, 4, 16> pool;
+  std::vector<Message*> msgs;
+  for (int i = 0; i < 20; i++)
+    msgs.push_back(pool.create(i));
+  auto stats = pool.getStats();
+  EXPECT_EQ(2u, stats.slabs);
+  EXPECT_EQ(32u, stats.capacity);
+  EXPECT_EQ(20u, stats.live);
+  for (int i = 0; i < 20; i++) {
+    EXPECT_EQ(i, msgs[i]->id);
+    EXPECT_EQ(i, msgs[i]->payload[3]);
+  }
+
+  Message* last = msgs.back();
+  pool.destroy(last);
+  msgs.pop_back();
+  // Slots are reused from the cache of the thread
+  EXPECT_EQ(last, pool.create(42));
+  EXPECT_EQ(42, last->id);
+  msgs.push_back(last);
+
+  for (Message* msg : msgs)
+    pool.destroy(msg);
+  stats = pool.getStats();
+  EXPECT_EQ(0u, stats.live);
+  EXPECT_EQ(2u, stats.slabs);
+}
+
+TEST(ObjectPool, Threads) {
+  ObjectPool<Message, 8, 64, 4> pool;
+  std::array<std::vector<Message*>, thread_count> created;
+  std::array<std::thread, thread_count> threads;
+
+  // More threads than caches, each destroys the objects of another thread
+  for (unsigned i = 0; i < thread_count; i++)
+    threads[i] = std::thread([&, i] {
+      for (int j = 0; j < 1000; j++) {
+        Message* msg = pool.create(j);
+        if (j % 4)
+          pool.destroy(msg);
+        else
+          created[i].push_back(msg);
+      }
+    });
+  for (auto& t : threads)
+    t.join();
+  EXPECT_EQ(thread_count * 250u, pool.getStats().live);
+
+  for (unsigned i = 0; i < thread_count; i++)
+    threads[i] = std::thread([&, i] {
+      for (Message* msg : created[(i + 1) % thread_count]) {
+        EXPECT_EQ(0, msg->id % 4);
+        pool.destroy(msg);
+      }
+    });
+  for (auto& t : threads)
+    t.join();
+  auto stats = pool.getStats();
+  EXPECT_EQ(0u, stats.live);
+  EXPECT_LE(stats.capacity, thread_count * 1000u);
+}
+
+} // namespace
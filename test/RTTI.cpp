@@ -1,4 +1,6 @@
 #include "sigta/common/RTTI.h"
+#include "sigta/common/Casting.h"
+#include "sigta/common/ClassFilter.h"
 #include "gtest/gtest.h"
 
 using namespace sigta;
@@ -32,6 +34,44 @@ TEST(RTTI, LinearID) {
   }
 }
 
+TEST(RTTI, StableLinearID) {
+  using TestID = rtti::LinearID<struct StableIDTest, uint16_t, 1, true>;
+  using Types = std::tuple<struct A, struct B, struct C, struct D, struct E>;
+  std::array<uint64_t, 5> hashes = {
+      rtti::typeHash<std::tuple_element_t<0, Types>>(),
+      rtti::typeHash<std::tuple_element_t<1, Types>>(),
+      rtti::typeHash<std::tuple_element_t<2, Types>>(),
+      rtti::typeHash<std::tuple_element_t<3, Types>>(),
+      rtti::typeHash<std::tuple_element_t<4, Types>>()};
+  TestID::init();
+  std::array arr = {TestID::get<std::tuple_element_t<0, Types>>(),
+                    TestID::get<std::tuple_element_t<1, Types>>(),
+                    TestID::get<std::tuple_element_t<2, Types>>(),
+                    TestID::get<std::tuple_element_t<3, Types>>(),
+                    TestID::get<std::tuple_element_t<4, Types>>()};
+  EXPECT_EQ(5u, TestID::countIDs());
+  for (unsigned i = 0; i < arr.size(); i++)
+    for (unsigned k = 0; k < arr.size(); k++)
+      EXPECT_EQ(hashes[i] < hashes[k], arr[i].getInt() < arr[k].getInt());
+
+  std::vector<rtti::ManifestEntry> manifest = TestID::getManifest();
+  ASSERT_EQ(5u, manifest.size());
+  for (unsigned i = 0; i < arr.size(); i++)
+    EXPECT_EQ(hashes[i], manifest[arr[i].getInt() - 1].hash);
+
+  /// Simulate a build where the types had other IDs and one is unknown
+  std::vector<rtti::ManifestEntry> old;
+  for (unsigned i = 0; i < arr.size(); i++)
+    old.push_back({hashes[i], 10 + i});
+  old.push_back({rtti::typeHash<struct Unknown>(), 15});
+  rtti::IDRemapper<uint16_t> remapper(old, manifest);
+  for (unsigned i = 0; i < arr.size(); i++)
+    EXPECT_EQ(arr[i].getInt(), remapper.remap(10 + i));
+  EXPECT_EQ(remapper.invalid, remapper.remap(15));
+  EXPECT_EQ(remapper.invalid, remapper.remap(9));
+  EXPECT_EQ(remapper.invalid, remapper.remap(16));
+}
+
 struct Base;
 
 using ClassID = rtti::HierarchyID<Base>;
@@ -58,8 +98,13 @@ struct ACA : Base, ClassID::Inherits<ACA, AC> { ACA() : Base(ClassID::get<ACA>()
 struct ACB : Base, ClassID::Inherits<ACB, AC> { ACB() : Base(ClassID::get<ACB>()) {}};
 struct ACC : Base, ClassID::Inherits<ACC, AC> { ACC() : Base(ClassID::get<ACC>()) {}};
 
+void initClassID() {
+  static bool done = (ClassID::init(), true);
+  (void)done;
+}
+
 TEST(RTTI, HierarchyID) {
-  ClassID::init();
+  initClassID();
 
   EXPECT_TRUE(ClassID::isclassof<A>(ClassID::get<A>()));
   EXPECT_TRUE(ClassID::isclassof<B>(ClassID::get<B>()));
@@ -132,4 +177,178 @@ TEST(RTTI, HierarchyID) {
   EXPECT_FALSE(ClassID::isclassof<B>(ClassID::get<ACC>()));
 }
 
+TEST(RTTI, ClassFilter) {
+  initClassID();
+
+  std::vector<ClassID> ids;
+  for (int i = 0; i < 7; i++)
+    for (ClassID id : {ClassID::get<A>(), ClassID::get<B>(), ClassID::get<AA>(),
+                       ClassID::get<ACB>(), ClassID::get<BC>(),
+                       ClassID::get<AE>(), ClassID::get<Base>()})
+      ids.push_back(id);
+
+  auto check = [&](auto* tag) {
+    using Ty = std::remove_pointer_t<decltype(tag)>;
+    std::vector<ClassID> expected;
+    std::copy_if(ids.begin(), ids.end(), std::back_inserter(expected),
+                 [](ClassID id) { return ClassID::isclassof<Ty>(id); });
+    std::vector<ClassID> out(ids.size());
+
+    EXPECT_EQ(expected.size(), rtti::countClassOf<Ty>(ids.data(), ids.size()));
+    std::size_t count = rtti::filterClassOf<Ty>(ids.data(), ids.size(), out.data());
+    ASSERT_EQ(expected.size(), count);
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), out.begin()));
+
+    count = rtti::partitionClassOf<Ty>(ids.data(), ids.size(), out.data());
+    ASSERT_EQ(expected.size(), count);
+    std::copy_if(ids.begin(), ids.end(), std::back_inserter(expected),
+                 [](ClassID id) { return !ClassID::isclassof<Ty>(id); });
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), out.begin()));
+  };
+  check((Base*)nullptr);
+  check((A*)nullptr);
+  check((B*)nullptr);
+  check((AC*)nullptr);
+  check((ACB*)nullptr);
+  check((BA*)nullptr);
+
+  std::vector<uint8_t> classes(ids.size());
+  rtti::classifyClassOf<AC, B, AA>(ids.data(), ids.size(), classes.data());
+  for (unsigned i = 0; i < ids.size(); i++) {
+    uint8_t expected = ClassID::isclassof<AC>(ids[i])   ? 0
+                       : ClassID::isclassof<B>(ids[i])  ? 1
+                       : ClassID::isclassof<AA>(ids[i]) ? 2
+                                                         : 3;
+    EXPECT_EQ(expected, classes[i]);
+  }
+
+  AA aa;
+  BB bb;
+  ACC acc;
+  B b;
+  std::vector<Base*> objs = {&aa, &bb, &acc, &b};
+  auto proj = [](Base* obj) { return obj->ID; };
+  EXPECT_EQ(2u, rtti::countClassOf<A>(objs.begin(), objs.end(), proj));
+  std::vector<Base*> bs;
+  rtti::filterClassOf<B>(objs.begin(), objs.end(), std::back_inserter(bs),
+                         proj);
+  EXPECT_EQ((std::vector<Base*>{&bb, &b}), bs);
+  auto mid = rtti::partitionClassOf<B>(objs.begin(), objs.end(), proj);
+  EXPECT_EQ(2, mid - objs.begin());
+  EXPECT_TRUE(ClassID::isclassof<B>(objs[0]->ID));
+  EXPECT_TRUE(ClassID::isclassof<B>(objs[1]->ID));
+  EXPECT_FALSE(ClassID::isclassof<B>(objs[2]->ID));
+  EXPECT_FALSE(ClassID::isclassof<B>(objs[3]->ID));
+}
+
+struct Shape;
+
+using ShapeID = rtti::HierarchyID<Shape>;
+
+struct Shape {
+  ShapeID ID;
+  Shape(ShapeID id) : ID(id) {}
+  ShapeID getHierarchyID() const { return ID; }
+};
+
+struct Circle : Shape, ShapeID::Inherits<Circle, Shape> {
+  Circle() : Shape(ShapeID::get<Circle>()) {}
+};
+struct Polygon : Shape, ShapeID::Inherits<Polygon, Shape> {
+  Polygon(ShapeID id = ShapeID::get<Polygon>()) : Shape(id) {}
+};
+struct Square : Polygon, ShapeID::Inherits<Square, Polygon> {
+  Square() : Polygon(ShapeID::get<Square>()) {}
+};
+struct Triangle : Polygon, ShapeID::Inherits<Triangle, Polygon> {
+  Triangle() : Polygon(ShapeID::get<Triangle>()) {}
+};
+
+TEST(RTTI, Casting) {
+  ShapeID::init();
+  Circle circle;
+  Polygon polygon;
+  Square square;
+  Triangle triangle;
+  Shape* shapes[] = {&circle, &polygon, &square, &triangle};
+
+  EXPECT_TRUE(rtti::isa<Circle>(shapes[0]));
+  EXPECT_FALSE(rtti::isa<Polygon>(shapes[0]));
+  EXPECT_TRUE(rtti::isa<Polygon>(*shapes[2]));
+  EXPECT_TRUE(rtti::isa<Shape>(shapes[3]));
+
+  EXPECT_EQ(&square, rtti::cast<Square>(shapes[2]));
+  EXPECT_EQ(&square, &rtti::cast<Polygon>(*shapes[2]));
+  const Shape* constShape = shapes[3];
+  EXPECT_EQ(&triangle, rtti::cast<Triangle>(constShape));
+
+  EXPECT_EQ(nullptr, rtti::dyn_cast<Square>(shapes[0]));
+  EXPECT_EQ(nullptr, rtti::dyn_cast<Square>((Shape*)nullptr));
+  EXPECT_EQ(&triangle, rtti::dyn_cast<Polygon>(shapes[3]));
+
+  auto name = [](Shape& shape) {
+    return rtti::type_switch<Polygon, Square, Circle>(
+        shape, [](Polygon&) { return 1; }, [](Square&) { return 2; },
+        [](Circle&) { return 3; });
+  };
+  EXPECT_EQ(3, name(circle));
+  EXPECT_EQ(1, name(polygon));
+  EXPECT_EQ(2, name(square));
+  EXPECT_EQ(1, name(triangle));
+
+  int visited = 0;
+  for (const Shape* shape : shapes)
+    rtti::type_switch<Square, Triangle>(
+        *shape, [&](const Square&) { visited += 1; },
+        [&](const Triangle&) { visited += 10; },
+        [&](const Shape&) { visited += 100; });
+  EXPECT_EQ(211, visited);
+}
+
+TEST(RTTI, typeName) {
+  static_assert(rtti::typeName<int>() == "int");
+  static_assert(rtti::typeHash<int>() != rtti::typeHash<unsigned>());
+  std::string_view name = rtti::typeName<Shape>();
+  EXPECT_EQ("::Shape", name.substr(name.size() - 7));
+}
+
+struct Animal;
+
+using AnimalID = rtti::HierarchyID<Animal, uint16_t, 0, true>;
+
+struct Animal {};
+struct Dog : Animal, AnimalID::Inherits<Dog, Animal> {};
+struct Cat : Animal, AnimalID::Inherits<Cat, Animal> {};
+struct Bird : Animal, AnimalID::Inherits<Bird, Animal> {};
+struct Puppy : Dog, AnimalID::Inherits<Puppy, Dog> {};
+struct Kitten : Cat, AnimalID::Inherits<Kitten, Cat> {};
+
+TEST(RTTI, StableHierarchyID) {
+  AnimalID::init();
+  Puppy puppy;
+  Kitten kitten;
+  Bird bird;
+  auto checkOrder = [](auto* l, auto* r) {
+    using LTy = std::remove_pointer_t<decltype(l)>;
+    using RTy = std::remove_pointer_t<decltype(r)>;
+    EXPECT_EQ(rtti::typeHash<LTy>() < rtti::typeHash<RTy>(),
+              AnimalID::get<LTy>().getInt() < AnimalID::get<RTy>().getInt());
+  };
+  checkOrder((Dog*)nullptr, (Cat*)nullptr);
+  checkOrder((Dog*)nullptr, (Bird*)nullptr);
+  checkOrder((Cat*)nullptr, (Bird*)nullptr);
+  EXPECT_TRUE(AnimalID::isclassof<Dog>(AnimalID::get<Puppy>()));
+  EXPECT_TRUE(AnimalID::isclassof<Cat>(AnimalID::get<Kitten>()));
+  EXPECT_FALSE(AnimalID::isclassof<Cat>(AnimalID::get<Puppy>()));
+  EXPECT_EQ(0, AnimalID::get<Animal>().getInt());
+
+  const std::vector<rtti::ManifestEntry>& manifest = AnimalID::getManifest();
+  ASSERT_EQ(6u, manifest.size());
+  rtti::IDRemapper<uint16_t> identity(manifest, manifest);
+  for (rtti::ManifestEntry entry : manifest)
+    EXPECT_EQ(entry.id, identity.remap(entry.id));
+  EXPECT_EQ(rtti::typeHash<Kitten>(),
+            manifest[AnimalID::get<Kitten>().getInt()].hash);
+}
+
 } // namespace
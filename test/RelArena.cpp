@@ -0,0 +1,87 @@
+#include "sigta/common/RelArena.h"
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+using namespace sigta;
+
+namespace {
+
+struct Node {
+  RelArena<int16_t>::Ptr<Node> next;
+  RelArena<int16_t>::Ptr<Node> prev;
+  int value;
+};
+
+TEST(RelArena, Graph) {
+  RelArena<int16_t> arena;
+  EXPECT_EQ(RelArena<int16_t>::maxCapacity, arena.getCapacity());
+  Node* head = arena.create<Node>();
+  head->value = 0;
+  Node* last = head;
+  unsigned count = 1;
+  while (Node* n = arena.create<Node>()) {
+    n->value = count++;
+    n->prev = last;
+    last->next = n;
+    last = n;
+  }
+  /// The arena is full, every offset still fit in 16 bits
+  EXPECT_GT(count, 1000u);
+  EXPECT_EQ(nullptr, arena.createArray<char>(arena.getCapacity()));
+  EXPECT_TRUE(arena.contains(last));
+  arena.freeze();
+
+  std::unique_ptr<char[]> copy(new char[arena.size()]);
+  std::memcpy(copy.get(), arena.data(), arena.size());
+  RelArena<int16_t> moved = std::move(arena);
+  EXPECT_EQ(nullptr, arena.data());
+
+  unsigned idx = 0;
+  Node* tail = nullptr;
+  for (Node* n = reinterpret_cast<Node*>(copy.get()); n; n = n->next.get()) {
+    EXPECT_EQ(idx++, (unsigned)n->value);
+    tail = n;
+  }
+  EXPECT_EQ(count, idx);
+  for (Node* n = tail; n; n = n->prev.get())
+    EXPECT_EQ(--idx, (unsigned)n->value);
+  EXPECT_EQ(reinterpret_cast<Node*>(moved.data())->next->value, 1);
+}
+
+TEST(RelArena, Containers) {
+  struct Root {
+    RelString<> name;
+    RelVector<int> vec;
+    RelSpan<long> span;
+    RelHashMap<RelString<>, unsigned> map;
+  };
+  RelArena<> arena(1 << 20);
+  Root* root = arena.create<Root>();
+  ASSERT_TRUE(arena.setString(root->name, "name"));
+  ASSERT_TRUE(arena.setVector(root->vec, 2));
+  root->vec.push_back(4);
+  ASSERT_TRUE(arena.setSpan(root->span, 3));
+  root->span[2] = 5;
+  ASSERT_TRUE(arena.setHashMap(root->map, 10));
+  for (unsigned i = 0; i < 10; i++) {
+    auto& slot = root->map.insertSlot(std::to_string(i));
+    ASSERT_TRUE(arena.setString(slot.key, std::to_string(i)));
+    slot.value = i;
+  }
+  arena.freeze();
+
+  std::unique_ptr<char[]> copy(new char[arena.size()]);
+  std::memcpy(copy.get(), arena.data(), arena.size());
+  Root* res = reinterpret_cast<Root*>(copy.get());
+  EXPECT_EQ("name", res->name);
+  EXPECT_EQ(4, res->vec[0]);
+  EXPECT_EQ(0, res->span[0]);
+  EXPECT_EQ(5, res->span[2]);
+  for (unsigned i = 0; i < 10; i++)
+    EXPECT_EQ(i, *res->map.find(std::to_string(i)));
+}
+
+} // namespace
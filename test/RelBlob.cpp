@@ -0,0 +1,140 @@
+#include "sigta/common/RelArena.h"
+#include "sigta/common/RelBlob.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+using namespace sigta;
+
+namespace {
+
+struct Item {
+  int a;
+  float b;
+};
+
+struct Node {
+  RelPtr<Node, int32_t> next;
+  RelString<> label;
+};
+
+struct Root {
+  RelString<> name;
+  RelVector<Item> items;
+  RelHashMap<RelString<>, uint32_t> index;
+  RelPtr<Node, int32_t> list;
+};
+
+} // namespace
+
+template <>
+struct sigta::RelSchema<Item> : RelFields<> {};
+template <>
+struct sigta::RelSchema<Node> : RelFields<&Node::next, &Node::label> {};
+template <>
+struct sigta::RelSchema<Root>
+    : RelFields<&Root::name, &Root::items, &Root::index, &Root::list> {};
+
+namespace {
+
+constexpr uint64_t magic = 0x5349475441424c42;
+
+enum class Corruption { None, Misaligned, OutOfBounds, BadString };
+
+std::string writeBlob(Corruption corruption) {
+  RelArena<> arena(1 << 20);
+  Root* root = arena.create<Root>();
+  arena.setString(root->name, "root");
+  arena.setVector(root->items, 10);
+  for (int i = 0; i < 10; i++)
+    root->items.push_back({i, i / 2.0f});
+  arena.setHashMap(root->index, 10);
+  for (uint32_t i = 0; i < 10; i++) {
+    auto& slot = root->index.insertSlot(std::to_string(i));
+    arena.setString(slot.key, std::to_string(i));
+    slot.value = i;
+  }
+  // A cycle of 3 nodes
+  Node* nodes[3];
+  for (Node*& node : nodes) {
+    node = arena.create<Node>();
+    arena.setString(node->label, "node");
+  }
+  for (int i = 0; i < 3; i++)
+    nodes[i]->next = nodes[(i + 1) % 3];
+  root->list = nodes[0];
+
+  switch (corruption) {
+  case Corruption::None:
+    break;
+  case Corruption::Misaligned:
+    nodes[2]->next = reinterpret_cast<Node*>(arena.data() + 1);
+    break;
+  case Corruption::OutOfBounds:
+    nodes[2]->next = reinterpret_cast<Node*>(arena.data() + arena.size());
+    break;
+  case Corruption::BadString:
+    const_cast<char*>(nodes[1]->label.data())[4] = 'x';
+    break;
+  }
+
+  std::string path = testing::TempDir() + "sigta_relblob_" +
+                     std::to_string((int)corruption) + ".bin";
+  EXPECT_TRUE(writeRelBlob(path.c_str(), magic, 1, arena.data(), arena.size()));
+  return path;
+}
+
+TEST(RelBlob, Load) {
+  std::string path = writeBlob(Corruption::None);
+  RelBlob blob;
+  ASSERT_EQ(RelBlobStatus::Ok, blob.open<Root>(path.c_str(), magic, 1));
+  const Root* root = blob.getRoot<Root>();
+  EXPECT_EQ("root", root->name);
+  ASSERT_EQ(10u, root->items.size());
+  EXPECT_EQ(9, root->items[9].a);
+  EXPECT_EQ(7u, *root->index.find("7"));
+  const Node* node = root->list.get();
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ("node", node->label);
+    node = node->next.get();
+  }
+  EXPECT_EQ(root->list.get(), node);
+
+  RelBlob other;
+  EXPECT_EQ(RelBlobStatus::BadMagic, other.open<Root>(path.c_str(), 0, 1));
+  EXPECT_EQ(RelBlobStatus::BadVersion, other.open<Root>(path.c_str(), magic, 2));
+  EXPECT_EQ(0u, other.size());
+  EXPECT_EQ(RelBlobStatus::OpenFailed,
+            other.open<Root>((path + "missing").c_str(), magic, 1));
+  std::remove(path.c_str());
+}
+
+TEST(RelBlob, Corrupted) {
+  for (Corruption corruption : {Corruption::Misaligned,
+                                Corruption::OutOfBounds,
+                                Corruption::BadString}) {
+    std::string path = writeBlob(corruption);
+    RelBlob blob;
+    EXPECT_EQ(RelBlobStatus::BadPointer,
+              blob.open<Root>(path.c_str(), magic, 1));
+    std::remove(path.c_str());
+  }
+
+  std::string path = writeBlob(Corruption::None);
+  FILE* file = std::fopen(path.c_str(), "r+b");
+  std::fseek(file, sizeof(RelBlobHeader) + 3, SEEK_SET);
+  std::fputc(0x7f, file);
+  std::fclose(file);
+  RelBlob blob;
+  EXPECT_EQ(RelBlobStatus::BadChecksum, blob.open<Root>(path.c_str(), magic, 1));
+
+  file = std::fopen(path.c_str(), "r+b");
+  std::fseek(file, -1, SEEK_END);
+  std::fputc(0, file);
+  std::fputc(0, file);
+  std::fclose(file);
+  EXPECT_EQ(RelBlobStatus::BadHeader, blob.open<Root>(path.c_str(), magic, 1));
+  std::remove(path.c_str());
+}
+
+} // namespace
@@ -0,0 +1,108 @@
+#include "sigta/common/RelArena.h"
+#include "sigta/common/RelBulk.h"
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+template <typename IntTy>
+void testResolve() {
+  // Keep pointers and pointees close enough for 32 bits offsets
+  RelArena<> arena(1 << 20);
+  int* values = arena.createArray<int>(100);
+  for (int i = 0; i < 100; i++)
+    values[i] = i * 3;
+  for (std::size_t size : {0, 1, 3, 4, 7, 8, 9, 31, 64, 65, 200}) {
+    auto* ptrs = arena.createArray<RelPtr<int, IntTy>>(size);
+    for (std::size_t i = 0; i < size; i++)
+      if (i % 5 != 2)
+        ptrs[i] = &values[(i * 7) % 100];
+    std::vector<int*> out(size, values);
+    resolveRelPtrs(ptrs, size, out.data());
+    for (std::size_t i = 0; i < size; i++)
+      EXPECT_EQ(ptrs[i].get(), out[i]);
+
+    std::vector<int> gathered(size);
+    gatherRelPtrs(ptrs, size, gathered.data(), -1);
+    for (std::size_t i = 0; i < size; i++)
+      EXPECT_EQ(ptrs[i] ? *ptrs[i] : -1, gathered[i]);
+  }
+}
+
+TEST(RelBulk, Resolve) {
+  testResolve<int32_t>();
+  testResolve<std::ptrdiff_t>();
+}
+
+TEST(RelBulk, Gather) {
+  struct Item {
+    float f;
+    double d;
+    char c[3];
+  };
+  RelArena<> arena(1 << 20);
+  Item* items = arena.createArray<Item>(40);
+  auto* floats = arena.createArray<RelPtr<float, int32_t>>(40);
+  auto* doubles = arena.createArray<RelPtr<double, int32_t>>(40);
+  auto* chars = arena.createArray<RelPtr<Item, int32_t>>(40);
+  for (int i = 0; i < 40; i++) {
+    items[i] = {i * 0.5f, i * 0.25, {(char)i, 0, 0}};
+    if (i % 3) {
+      floats[i] = &items[39 - i].f;
+      doubles[i] = &items[39 - i].d;
+      chars[i] = &items[39 - i];
+    }
+  }
+  float fs[40];
+  double ds[40];
+  Item cs[40];
+  gatherRelPtrs(floats, 37, fs, -1.0f);
+  gatherRelPtrs(doubles, 37, ds, -1.0);
+  gatherRelPtrs(chars, 37, cs);
+  for (int i = 0; i < 37; i++) {
+    EXPECT_EQ(i % 3 ? (39 - i) * 0.5f : -1.0f, fs[i]);
+    EXPECT_EQ(i % 3 ? (39 - i) * 0.25 : -1.0, ds[i]);
+    EXPECT_EQ(i % 3 ? 39 - i : 0, cs[i].c[0]);
+  }
+}
+
+TEST(RelBulk, BackwardAndSpan) {
+  struct Root {
+    RelSpan<RelPtr<double, int32_t>> ptrs;
+  };
+  RelArena<> arena(1 << 20);
+  double* values = arena.createArray<double>(50);
+  Root* root = arena.create<Root>();
+  arena.setSpan(root->ptrs, 50);
+  for (int i = 0; i < 50; i++) {
+    values[i] = i / 2.0;
+    root->ptrs[i] = &values[49 - i];
+  }
+  root->ptrs[10] = nullptr;
+
+  double* addrs[50];
+  resolveRelPtrs(root->ptrs, addrs);
+  EXPECT_EQ(&values[49], addrs[0]);
+  EXPECT_EQ(nullptr, addrs[10]);
+  EXPECT_EQ(&values[0], addrs[49]);
+
+  double gathered[50];
+  gatherRelPtrs(root->ptrs, gathered);
+  EXPECT_EQ(24.5, gathered[0]);
+  EXPECT_EQ(0.0, gathered[10]);
+
+  std::size_t count = 0;
+  double sum = 0;
+  for (const double* p : prefetchRelPtrs(root->ptrs)) {
+    if (p)
+      sum += *p;
+    count++;
+  }
+  EXPECT_EQ(50u, count);
+  EXPECT_EQ(612.5 - 19.5, sum);
+}
+
+} // namespace
@@ -0,0 +1,116 @@
+#include "sigta/common/RelBuilder.h"
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+using namespace sigta;
+
+namespace {
+
+struct Point {
+  int x;
+  int y;
+};
+
+struct Root {
+  RelString<> name;
+  RelVector<int> vec;
+  RelSpan<Point, int16_t> points;
+  RelHashMap<RelString<>, int> byName;
+  RelHashMap<uint32_t, RelString<int16_t>, int16_t> byID;
+};
+
+using ByIDTy = decltype(Root::byID);
+
+std::vector<char> buildBlob() {
+  RelBuilder builder;
+  auto root = builder.create<Root>();
+  builder.setString(builder.field(root, &Root::name), "root");
+
+  builder.setVector(builder.field(root, &Root::vec), 4);
+  builder.get(root)->vec.push_back(1);
+  builder.get(root)->vec.push_back(2);
+
+  auto points = builder.setSpan(builder.field(root, &Root::points), 3);
+  for (int i = 0; i < 3; i++)
+    *builder.get(builder.index(points, i)) = {i, i * 2};
+
+  auto byName = builder.field(root, &Root::byName);
+  builder.setHashMap(byName, 100);
+  for (int i = 0; i < 100; i++)
+    builder.get(builder.insert(byName, "key" + std::to_string(i)))->value = i;
+
+  auto byID = builder.field(root, &Root::byID);
+  builder.setHashMap(byID, 10);
+  for (uint32_t i = 0; i < 10; i++) {
+    auto slot = builder.insert(byID, i * 7);
+    builder.setString(builder.field(slot, &ByIDTy::Slot::value),
+                      std::to_string(i));
+  }
+  return {builder.data(), builder.data() + builder.size()};
+}
+
+TEST(RelContainers, Blob) {
+  std::vector<char> blob = buildBlob();
+  /// The blob is usable anywhere after a plain copy
+  std::unique_ptr<char[]> copy(new char[blob.size()]);
+  std::memcpy(copy.get(), blob.data(), blob.size());
+  blob.clear();
+  Root& root = *reinterpret_cast<Root*>(copy.get());
+
+  EXPECT_EQ("root", root.name);
+  EXPECT_EQ(std::string("root"), root.name.c_str());
+
+  EXPECT_EQ(2u, root.vec.size());
+  EXPECT_EQ(4u, root.vec.capacity());
+  EXPECT_EQ(1, root.vec[0]);
+  EXPECT_EQ(2, root.vec[1]);
+  root.vec.emplace_back(3);
+  EXPECT_EQ(3, root.vec[2]);
+
+  ASSERT_EQ(3u, root.points.size());
+  int i = 0;
+  for (Point& p : root.points) {
+    EXPECT_EQ(i, p.x);
+    EXPECT_EQ(i * 2, p.y);
+    i++;
+  }
+
+  EXPECT_EQ(100u, root.byName.size());
+  for (int i = 0; i < 100; i++) {
+    int* value = root.byName.find("key" + std::to_string(i));
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_EQ(nullptr, root.byName.find("key100"));
+  EXPECT_FALSE(root.byName.contains(""));
+
+  EXPECT_EQ(10u, root.byID.size());
+  for (uint32_t i = 0; i < 10; i++) {
+    auto* value = root.byID.find(i * 7);
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(std::to_string(i), *value);
+  }
+  EXPECT_EQ(nullptr, root.byID.find(1u));
+  unsigned count = 0;
+  root.byID.forEach([&](uint32_t key, const RelString<int16_t>& value) {
+    EXPECT_EQ(std::to_string(key / 7), value);
+    count++;
+  });
+  EXPECT_EQ(10u, count);
+}
+
+TEST(RelContainers, Empty) {
+  RelBuilder builder;
+  auto root = builder.create<Root>();
+  Root& r = *builder.get(root);
+  EXPECT_TRUE(r.name.empty());
+  EXPECT_EQ("", r.name);
+  EXPECT_TRUE(r.vec.empty());
+  EXPECT_EQ(r.points.begin(), r.points.end());
+  EXPECT_EQ(nullptr, r.byName.find("a"));
+}
+
+} // namespace
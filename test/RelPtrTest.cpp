@@ -1,4 +1,9 @@
+#include <algorithm>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
 #include "sigta/common/RelPtr.h"
 #include "gtest/gtest.h"
 
@@ -54,4 +59,102 @@ TEST(RelPtr, Null) {
   EXPECT_EQ(p5.get(), (int*)nullptr);
 }
 
+TEST(RelPtr, Compressed) {
+  static_assert(sizeof(CompressedPtr<int>) == 4);
+  static_assert(std::is_trivially_copyable_v<CompressedPtr<int>>);
+  static_assert(!std::is_copy_constructible_v<RelPtr<int>>);
+
+  int region[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  int copy[8] = {0, 10, 20, 30, 40, 50, 60, 70};
+  std::vector<CompressedPtr<int>> ptrs;
+  {
+    RelBaseScope<RelBaseTraits<uint32_t>> scope(region);
+    for (int i = 7; i >= 0; i--)
+      ptrs.push_back(&region[i]);
+    ptrs.push_back(nullptr);
+    EXPECT_EQ(*ptrs[0], 7);
+    std::sort(ptrs.begin(), ptrs.end() - 1);
+    EXPECT_EQ(ptrs[0].get(), &region[0]);
+    std::unordered_set<CompressedPtr<int>> set(ptrs.begin(), ptrs.end());
+    EXPECT_EQ(set.size(), 9u);
+    EXPECT_TRUE(set.count(CompressedPtr<int>(&region[3])));
+  }
+  // The same offsets used with another base
+  RelBaseScope<RelBaseTraits<uint32_t>> scope(copy);
+  CompressedPtr<int> p = ptrs[5];
+  EXPECT_EQ(*p, 50);
+  EXPECT_EQ(ptrs[8].get(), nullptr);
+}
+
+TEST(RelPtr, Shifted) {
+  static_assert(sizeof(ShiftedRelPtr<int64_t, int8_t>) == 1);
+  struct A {
+    int64_t values[100];
+    char pad[7];
+    ShiftedRelPtr<int64_t, int8_t> p;
+  } a;
+  a.values[1] = 1;
+  // Out of reach of a RelPtr<int64_t, int8_t>
+  a.p = &a.values[1];
+  EXPECT_EQ(*a.p, 1);
+  a.p = nullptr;
+  EXPECT_EQ(a.p.get(), nullptr);
+
+  alignas(8) char buffer[sizeof(A)];
+  a.p = &a.values[2];
+  std::memcpy(buffer, &a, sizeof(A));
+  A &b = *reinterpret_cast<A *>(buffer);
+  EXPECT_EQ(b.p.get(), &b.values[2]);
+}
+
+TEST(RelPtr, Tagged) {
+  struct alignas(8) Node {
+    TaggedRelPtr<Node, 3> left;
+    TaggedRelPtr<Node, 3, int16_t> right;
+  };
+  static_assert(sizeof(Node) == 8);
+  Node nodes[3];
+  nodes[0].left.setPointerAndTag(&nodes[1], 5);
+  nodes[0].right = &nodes[2];
+  EXPECT_EQ(nodes[0].left.get(), &nodes[1]);
+  EXPECT_EQ(nodes[0].left.getTag(), 5u);
+  EXPECT_EQ(nodes[0].right.get(), &nodes[2]);
+  EXPECT_EQ(nodes[0].right.getTag(), 0u);
+
+  nodes[0].right.setTag(TaggedRelPtr<Node, 3>::maxTag);
+  EXPECT_EQ(nodes[0].right.get(), &nodes[2]);
+  EXPECT_EQ(nodes[0].right.getTag(), 7u);
+  nodes[0].right = nullptr;
+  EXPECT_FALSE(nodes[0].right);
+  EXPECT_EQ(nodes[0].right.getTag(), 7u);
+
+  // Backward pointers
+  nodes[2].left.setPointerAndTag(&nodes[0], 1);
+  EXPECT_EQ(nodes[2].left.get(), &nodes[0]);
+  EXPECT_EQ(nodes[2].left->left.get(), &nodes[1]);
+  EXPECT_EQ(nodes[2].left.getTag(), 1u);
+  EXPECT_EQ(nodes[1].left.get(), nullptr);
+}
+
+TEST(RelPtr, CompareWithRawPointer) {
+  struct Node {
+    int value = 0;
+    RelPtr<int, int8_t> ptr;
+  };
+  Node node;
+  node.ptr = &node.value;
+  // The heap is too far from node for an int8_t offset, these must not make a
+  // temporary RelPtr
+  auto far = std::make_unique<int>(0);
+  EXPECT_TRUE(node.ptr == &node.value);
+  EXPECT_TRUE(&node.value == node.ptr);
+  EXPECT_FALSE(node.ptr != &node.value);
+  EXPECT_TRUE(node.ptr != far.get());
+  EXPECT_TRUE(far.get() != node.ptr);
+  EXPECT_FALSE(node.ptr == far.get());
+  EXPECT_EQ(node.ptr < far.get(), std::less<int*>()(&node.value, far.get()));
+  EXPECT_EQ(far.get() < node.ptr, std::less<int*>()(far.get(), &node.value));
+  EXPECT_TRUE(node.ptr != nullptr);
+}
+
 } // anonymous namespace
@@ -0,0 +1,144 @@
+#include "sigta/common/RelShared.h"
+#include "gtest/gtest.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+
+using namespace sigta;
+
+namespace {
+
+struct Dataset {
+  RelString<> name;
+  RelVector<uint32_t> values;
+  RelHashMap<RelString<>, uint32_t> index;
+};
+
+Dataset* build(RelArena<>& arena, std::string_view name, uint32_t count) {
+  Dataset* data = arena.create<Dataset>();
+  arena.setString(data->name, name);
+  arena.setVector(data->values, count);
+  arena.setHashMap(data->index, count);
+  for (uint32_t i = 0; i < count; i++) {
+    data->values.push_back(i * i);
+    auto& slot = data->index.insertSlot(std::to_string(i));
+    arena.setString(slot.key, std::to_string(i));
+    slot.value = i;
+  }
+  return data;
+}
+
+std::string getName() {
+  return "/sigta_test_region_" + std::to_string(getpid());
+}
+
+TEST(RelShared, PublishAndAttach) {
+  std::string name = getName();
+  RelSharedRegion<> publisher;
+  ASSERT_TRUE(publisher.create(name.c_str(), 1 << 20));
+  RelSharedRegion<> other;
+  EXPECT_FALSE(other.create(name.c_str(), 1 << 20));
+
+  RelSharedRegion<> reader;
+  ASSERT_TRUE(reader.attach(name.c_str()));
+  EXPECT_FALSE(reader.isPublisher());
+  EXPECT_EQ(0u, reader.getGeneration());
+  EXPECT_EQ(nullptr, reader.getRoot<Dataset>());
+
+  Dataset* first = build(publisher.getArena(), "first", 10);
+  EXPECT_EQ(1u, publisher.publish(first));
+
+  // The reader maps the same memory at a different address
+  uint64_t generation = 0;
+  const Dataset* data = reader.getRoot<Dataset>(&generation);
+  ASSERT_NE(nullptr, data);
+  EXPECT_NE((const void*)first, (const void*)data);
+  EXPECT_EQ(1u, generation);
+  EXPECT_EQ("first", data->name);
+  EXPECT_EQ(81u, data->values[9]);
+  EXPECT_EQ(7u, *data->index.find("7"));
+  EXPECT_EQ(nullptr, reader.getRoot<uint64_t>());
+
+  Dataset* second = build(publisher.getArena(), "second", 20);
+  EXPECT_EQ(2u, publisher.publish(second));
+  EXPECT_EQ(2u, reader.getGeneration());
+  EXPECT_EQ("second", reader.getRoot<Dataset>()->name);
+  // Previous generations stay readable
+  EXPECT_EQ("first", data->name);
+
+  EXPECT_TRUE(RelSharedRegion<>::remove(name.c_str()));
+  EXPECT_FALSE(other.attach(name.c_str()));
+  EXPECT_EQ(19u, *reader.getRoot<Dataset>()->index.find("19"));
+}
+
+TEST(RelShared, OtherProcess) {
+  std::string name = getName();
+  RelSharedRegion<> publisher;
+  ASSERT_TRUE(publisher.create(name.c_str(), 1 << 20));
+  publisher.publish(build(publisher.getArena(), "shared", 100));
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    RelSharedRegion<> reader;
+    bool ok = reader.attach(name.c_str());
+    const Dataset* data = ok ? reader.getRoot<Dataset>() : nullptr;
+    ok = data && data->name == "shared" && data->values[99] == 99 * 99 &&
+         *data->index.find("42") == 42;
+    _exit(ok ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+  RelSharedRegion<>::remove(name.c_str());
+}
+
+TEST(RelShared, CorruptHeader) {
+  std::string name = getName();
+  RelSharedRegion<> publisher;
+  ASSERT_TRUE(publisher.create(name.c_str(), 4096));
+  publisher.publish(build(publisher.getArena(), "corrupt", 4));
+  RelSharedRegion<> reader;
+  ASSERT_TRUE(reader.attach(name.c_str()));
+  ASSERT_NE(nullptr, reader.getRoot<Dataset>());
+
+  // Another writable mapping standing for a buggy or hostile process. The
+  // header takes 64 bytes and current is its third field.
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  std::size_t size = 64 + 4096;
+  void* raw = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  ASSERT_NE(MAP_FAILED, raw);
+  auto* current = reinterpret_cast<std::atomic<uint64_t>*>(
+      static_cast<char*>(raw) + 16);
+  uint64_t valid = current->load();
+
+  for (uint64_t bad : {uint64_t(4096), uint64_t(4096 - 8), uint64_t(1) << 62,
+                       valid + 1}) {
+    current->store(bad);
+    EXPECT_EQ(0u, reader.getGeneration());
+    EXPECT_EQ(nullptr, reader.getRoot<Dataset>());
+  }
+
+  // A valid version pointing its root outside of the data
+  current->store(valid);
+  uint64_t* root = reinterpret_cast<uint64_t*>(static_cast<char*>(raw) + 64 +
+                                               valid + 16);
+  uint64_t validRoot = *root;
+  for (uint64_t bad : {uint64_t(4096), uint64_t(4096 - 1), ~uint64_t(0)}) {
+    *root = bad;
+    EXPECT_EQ(1u, reader.getGeneration());
+    EXPECT_EQ(nullptr, reader.getRoot<Dataset>());
+  }
+  *root = validRoot;
+  EXPECT_EQ("corrupt", reader.getRoot<Dataset>()->name);
+
+  munmap(raw, size);
+  RelSharedRegion<>::remove(name.c_str());
+}
+
+} // namespace
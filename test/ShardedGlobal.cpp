@@ -0,0 +1,96 @@
+#include "sigta/common/ManagedObjs.h"
+#include "sigta/common/ShardedGlobal.h"
+#include "gtest/gtest.h"
+#include "TestCommon.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace sigta;
+
+namespace {
+
+struct Stats {
+  std::atomic<uint64_t> events = 0;
+  std::atomic<int> limit;
+  Stats(int l = 0) : limit(l) {}
+};
+
+/// The thread can migrate between calls to local(), so only check that it
+/// returns one of the replicas
+template <typename T, std::size_t N>
+bool isShard(const ShardedGlobal<T, N>& sharded, const T* value) {
+  for (std::size_t idx = 0; idx < sharded.size(); idx++)
+    if (&sharded.getShard(idx) == value)
+      return true;
+  return false;
+}
+
+uint64_t getTotal(const ShardedGlobal<Stats>& stats) {
+  return stats.reduce(uint64_t(0), [](uint64_t sum, const Stats& s) {
+    return sum + s.events.load(std::memory_order_relaxed);
+  });
+}
+
+TEST(ShardedGlobal, Basic) {
+  ShardedGlobal<Stats> stats(7);
+  EXPECT_EQ(std::max(std::thread::hardware_concurrency(), 1u), stats.size());
+  for (std::size_t idx = 0; idx < stats.size(); idx++) {
+    EXPECT_EQ(7, stats.getShard(idx).limit);
+    // Each replica is on its own cache lines
+    EXPECT_EQ(0u, (uintptr_t)&stats.getShard(idx) % 64);
+  }
+
+  stats.local().events++;
+  stats.local().events++;
+  EXPECT_EQ(2u, getTotal(stats));
+
+  stats.forEach([](Stats& s) { s.limit = 3; });
+  for (std::size_t idx = 0; idx < stats.size(); idx++)
+    EXPECT_EQ(3, stats.getShard(idx).limit);
+
+  ShardedGlobal<Stats, 3> grouped;
+  EXPECT_EQ(3u, grouped.size());
+  EXPECT_TRUE(isShard(grouped, &grouped.local()));
+}
+
+ManagedGlobal<ShardedGlobal<ComplexObj, 4>> complex_global;
+ManagedGlobal<ShardedGlobal<Stats>> stats_global;
+
+struct Counter : ShardedGlobalRefCount<&stats_global> {};
+
+TEST(ShardedGlobal, Lifetime) {
+  ComplexObj::reset();
+  {
+    ShardedGlobalRefCount<&complex_global> a;
+    EXPECT_EQ(4u, ComplexObj::constructCount);
+    {
+      ShardedGlobalRefCount<&complex_global> b;
+      EXPECT_EQ(&a.getAll(), &b.getAll());
+      EXPECT_TRUE(isShard(b.getAll(), &b.get()));
+      EXPECT_EQ(4u, b.getAll().size());
+    }
+    EXPECT_EQ(0u, ComplexObj::destructCount);
+  }
+  EXPECT_EQ(4u, ComplexObj::destructCount);
+}
+
+TEST(ShardedGlobal, Threads) {
+  constexpr unsigned increments = 10000;
+  Counter keepAlive;
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < thread_count; i++)
+    threads.emplace_back([] {
+      Counter counter;
+      for (unsigned j = 0; j < increments; j++)
+        counter.get().events.fetch_add(1, std::memory_order_relaxed);
+    });
+  for (auto& t : threads)
+    t.join();
+  EXPECT_EQ(thread_count * increments, getTotal(keepAlive.getAll()));
+}
+
+} // namespace
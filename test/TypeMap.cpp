@@ -0,0 +1,95 @@
+#include "sigta/common/TypeMap.h"
+#include "TestCommon.h"
+#include "gtest/gtest.h"
+
+#include <array>
+#include <string>
+#include <thread>
+
+using namespace sigta;
+
+namespace {
+
+template <unsigned N>
+struct T {};
+
+using Map = TypeMap<std::string, struct TypeMapTest>;
+
+TEST(TypeMap, Basic) {
+  Map::ID::get<T<0>>();
+  Map::ID::get<T<1>>();
+  Map::ID::get<T<2>>();
+  Map map;
+  EXPECT_EQ(nullptr, map.get<T<0>>());
+  EXPECT_EQ("a", map.getOrEmplace<T<0>>("a"));
+  EXPECT_EQ("a", map.getOrEmplace<T<0>>("b"));
+  EXPECT_EQ("c", map.getOrEmplace<T<2>>("c"));
+  EXPECT_EQ("a", *map.get<T<0>>());
+  EXPECT_EQ(nullptr, map.get<T<1>>());
+  EXPECT_TRUE(map.erase<T<0>>());
+  EXPECT_FALSE(map.erase<T<0>>());
+  EXPECT_EQ(nullptr, map.get<T<0>>());
+  EXPECT_EQ("c", *map.get<T<2>>());
+}
+
+TEST(TypeMap, ComplexObj) {
+  ComplexObj::reset();
+  {
+    TypeMap<ComplexObj, struct TypeMapComplexTest> map;
+    map.getOrEmplace<T<0>>();
+    map.getOrEmplace<T<1>>();
+    map.getOrEmplace<T<0>>();
+    EXPECT_EQ(2, ComplexObj::constructCount);
+  }
+  EXPECT_EQ(2, ComplexObj::destructCount);
+}
+
+template <unsigned... Ns>
+void insertAll(UniqueTypeMap<unsigned>& map,
+               std::integer_sequence<unsigned, Ns...>) {
+  (map.getOrEmplace<T<Ns>>(Ns), ...);
+}
+
+template <unsigned... Ns>
+bool checkAll(const UniqueTypeMap<unsigned>& map,
+              std::integer_sequence<unsigned, Ns...>) {
+  return ((!map.get<T<Ns>>() || *map.get<T<Ns>>() == Ns) && ...);
+}
+
+TEST(TypeMap, Unique) {
+  UniqueTypeMap<unsigned> map;
+  EXPECT_EQ(nullptr, map.get<T<0>>());
+  EXPECT_EQ(1u, map.getOrEmplace<T<1>>(1u));
+  unsigned* one = map.get<T<1>>();
+  insertAll(map, std::make_integer_sequence<unsigned, 100>{});
+  EXPECT_EQ(one, map.get<T<1>>());
+  EXPECT_TRUE(checkAll(map, std::make_integer_sequence<unsigned, 100>{}));
+  EXPECT_EQ(nullptr, map.get<T<100>>());
+}
+
+TEST(TypeMap, Threads) {
+  UniqueTypeMap<unsigned> map;
+  std::atomic<bool> start = false;
+  std::atomic<bool> failed = false;
+
+  auto run = [&] {
+    while (!start);
+    insertAll(map, std::make_integer_sequence<unsigned, 64>{});
+    for (int i = 0; i < 100; i++)
+      if (!checkAll(map, std::make_integer_sequence<unsigned, 200>{}))
+        failed = true;
+  };
+
+  std::array<std::thread, thread_count> others;
+  for (auto &t : others)
+    t = std::thread(run);
+  start = true;
+  insertAll(map, std::make_integer_sequence<unsigned, 200>{});
+  for (auto &t : others)
+    t.join();
+  EXPECT_FALSE(failed);
+  EXPECT_TRUE(checkAll(map, std::make_integer_sequence<unsigned, 200>{}));
+  EXPECT_NE(nullptr, map.get<T<199>>());
+}
+
+} // namespace
@@ -0,0 +1,105 @@
+#include "sigta/common/ManagedObjs.h"
+#include "sigta/common/VersionedGlobal.h"
+#include "gtest/gtest.h"
+#include "TestCommon.h"
+
+#include <array>
+#include <thread>
+
+using namespace sigta;
+
+namespace {
+
+struct Config {
+  static inline std::atomic<int> live = 0;
+  /// Not atomic, TSan reports readers racing with the destructor
+  int version;
+  int copy;
+  Config(int v = 0) : version(v), copy(v) { live++; }
+  Config(const Config& other) : version(other.version), copy(other.copy) {
+    live++;
+  }
+  ~Config() {
+    version = -1;
+    copy = -2;
+    live--;
+  }
+};
+
+TEST(VersionedGlobal, Basic) {
+  {
+    VersionedGlobal<Config> config(1);
+    EXPECT_EQ(1, config.read()->version);
+    {
+      auto snap = config.read();
+      config.emplace(2);
+      // The old version stays alive while it is read
+      EXPECT_EQ(1, snap->version);
+      EXPECT_EQ(2, config.read()->version);
+      EXPECT_EQ(2, Config::live);
+      {
+        auto nested = config.read();
+        EXPECT_EQ(2, nested->version);
+      }
+    }
+    VersionedGlobal<Config>::reclaim();
+    EXPECT_EQ(1, Config::live);
+
+    config.update([](Config& c) {
+      c.version++;
+      c.copy++;
+    });
+    EXPECT_EQ(3, config.read()->version);
+    EXPECT_EQ(1, Config::live);
+  }
+  EXPECT_EQ(0, Config::live);
+}
+
+ManagedGlobal<VersionedGlobal<Config>> global;
+struct User : GlobalRefCount<&global> {};
+
+TEST(VersionedGlobal, Threads) {
+  std::atomic<bool> start = false;
+  std::atomic<bool> stop = false;
+  std::atomic<int> readers = 0;
+  User user;
+
+  auto read = [&] {
+    User u;
+    readers++;
+    while (!start);
+    int last = 0;
+    while (!stop) {
+      auto snap = u.get().read();
+      EXPECT_EQ(snap->version, snap->copy);
+      EXPECT_LE(last, snap->version);
+      last = snap->version;
+    }
+  };
+  auto write = [&] {
+    User u;
+    while (!start);
+    for (int i = 0; i < 500; i++)
+      u.get().update([](Config& c) {
+        c.version++;
+        c.copy++;
+      });
+  };
+
+  std::array<std::thread, thread_count> threads;
+  for (unsigned i = 0; i < thread_count; i++)
+    threads[i] = i < 2 ? std::thread(write) : std::thread(read);
+  start = true;
+  threads[0].join();
+  threads[1].join();
+  stop = true;
+  for (unsigned i = 2; i < thread_count; i++)
+    threads[i].join();
+  EXPECT_EQ((int)thread_count - 2, readers);
+
+  EXPECT_EQ(1000, user.get().read()->version);
+  VersionedGlobal<Config>::reclaim();
+  EXPECT_EQ(1, Config::live);
+}
+
+} // namespace